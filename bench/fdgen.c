@@ -0,0 +1,244 @@
+/* -----------------------------------------------------------------------------
+   fdgen — gerador de cargas sintéticas de DFs para os benchmarks.
+
+   Escreve um arquivo .fds (ou um arquivo de consultas) em stdout. Os
+   atributos se chamam A0..A(n-1); a saída depende só dos parâmetros e da
+   semente, em qualquer plataforma (PRNG próprio, splitmix64).
+
+   Tipos:
+     chain        A0->A1, A1->A2, ...: uma chave, fechos longos
+     deepchain    A1->A0, A2->A1, ... (cada passada sobre F avança um
+                  passo), mais DFs com A(n-1) no LHS até completar --fds
+     star         A0->Ai para todo i: um LHS alcança tudo de uma vez
+     random       --fds DFs com LHS de 1 a --lhs atributos e RHS de 1 a 2
+     cycle        Ai->A(i+1), fechado em ciclo: n chaves de um atributo
+     manykeys     pares A(2i)<->A(2i+1): 2^(n/2) chaves
+     adversarial  {A0..Ai}->A(i+1) em ordem inversa, mais DFs que nunca
+                  disparam até completar --fds: pior caso do fecho iterativo
+     queries      --count conjuntos aleatórios de 1 a --lhs atributos
+ ----------------------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+  const char *kind;
+  int attrs;
+  int fds;
+  int lhs;
+  int count;
+  uint64_t seed;
+} GenOptions;
+
+static uint64_t rngState;
+
+static uint64_t nextRandom(void)
+{
+  uint64_t z = (rngState += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Inteiro uniforme em [0, n)
+static int randomBelow(int n)
+{
+  return (int)(nextRandom() % (uint64_t)n);
+}
+
+static void printUsage(const char *programName)
+{
+  fprintf(stderr,
+          "Usage:\n"
+          "  %s chain|star|cycle|manykeys --attrs N\n"
+          "  %s deepchain --attrs N [--fds M]\n"
+          "  %s random --attrs N --fds M [--lhs K] [--seed S]\n"
+          "  %s adversarial --attrs N [--fds M]\n"
+          "  %s queries --attrs N --count Q [--lhs K] [--seed S]\n",
+          programName, programName, programName, programName, programName);
+}
+
+/* ------------------------------------------------------------
+   Saída
+------------------------------------------------------------ */
+static void printUniverse(int attrs)
+{
+  printf("U={");
+  for (int i = 0; i < attrs; ++i)
+    printf(i ? ",A%d" : "A%d", i);
+  printf("}\n");
+}
+
+// k atributos distintos sorteados, separados por espaço
+static void printRandomSet(int attrs, int k, char *chosen)
+{
+  memset(chosen, 0, attrs);
+  int first = 1;
+  while (k > 0)
+  {
+    int a = randomBelow(attrs);
+    if (chosen[a])
+      continue;
+    chosen[a] = 1;
+    printf(first ? "A%d" : " A%d", a);
+    first = 0;
+    k--;
+  }
+}
+
+/* ------------------------------------------------------------
+   Cargas
+------------------------------------------------------------ */
+static int generate(const GenOptions *options)
+{
+  int n = options->attrs;
+  const char *kind = options->kind;
+
+  if (strcmp(kind, "queries") == 0)
+  {
+    char *chosen = malloc(n);
+    if (!chosen)
+      return 1;
+    for (int q = 0; q < options->count; ++q)
+    {
+      printRandomSet(n, 1 + randomBelow(options->lhs < n ? options->lhs : n), chosen);
+      printf("\n");
+    }
+    free(chosen);
+    return 0;
+  }
+
+  printUniverse(n);
+  printf("F={");
+
+  if (strcmp(kind, "chain") == 0)
+  {
+    for (int i = 0; i + 1 < n; ++i)
+      printf(i ? ", A%d->A%d" : "A%d->A%d", i, i + 1);
+  }
+  else if (strcmp(kind, "deepchain") == 0)
+  {
+    /* Cadeia descendente sobre A0..A(n-2) */
+    int printed = 0;
+    for (int i = 0; i + 2 < n; ++i)
+      printf(printed++ ? ", A%d->A%d" : "A%d->A%d", i + 1, i);
+
+    /* Preenchimento: A(n-1) não é determinado por nada da cadeia; pares
+       distintos de atributos da cadeia, para que nenhum LHS se repita
+       (distância j - i até (m-1)/2: as maiores repetiriam os mesmos pares) */
+    int m = n - 2;
+    for (int t = 0; m > 1 && printed < options->fds && t < m * ((m - 1) / 2); ++t)
+    {
+      int i = t % m;
+      int j = (i + 1 + t / m) % m;
+      printf(printed++ ? ", " : "");
+      printf("A%d A%d A%d->A%d", i, j, n - 1, (j + 1) % m);
+    }
+  }
+  else if (strcmp(kind, "star") == 0)
+  {
+    for (int i = 1; i < n; ++i)
+      printf(i > 1 ? ", A0->A%d" : "A0->A%d", i);
+  }
+  else if (strcmp(kind, "cycle") == 0)
+  {
+    for (int i = 0; i < n; ++i)
+      printf(i ? ", A%d->A%d" : "A%d->A%d", i, (i + 1) % n);
+  }
+  else if (strcmp(kind, "manykeys") == 0)
+  {
+    for (int i = 0; i + 1 < n; i += 2)
+      printf(i ? ", A%d->A%d, A%d->A%d" : "A%d->A%d, A%d->A%d", i, i + 1, i + 1, i);
+  }
+  else if (strcmp(kind, "random") == 0)
+  {
+    char *chosen = malloc(n);
+    if (!chosen)
+      return 1;
+    int maxLhs = options->lhs < n ? options->lhs : n;
+    for (int i = 0; i < options->fds; ++i)
+    {
+      if (i)
+        printf(", ");
+      printRandomSet(n, 1 + randomBelow(maxLhs), chosen);
+      printf("->");
+      printRandomSet(n, 1 + randomBelow(n > 1 ? 2 : 1), chosen);
+    }
+    free(chosen);
+  }
+  else if (strcmp(kind, "adversarial") == 0)
+  {
+    /* Em ordem inversa, cada passada do laço iterativo só dispara a
+       última DF da lista que ainda falta */
+    int printed = 0;
+    for (int i = n - 3; i >= 0; --i)
+    {
+      printf(printed++ ? ", " : "");
+      for (int a = 0; a <= i; ++a)
+        printf(a ? " A%d" : "A%d", a);
+      printf("->A%d", i + 1);
+    }
+
+    /* Preenchimento: LHS com A(n-1), que nada determina */
+    for (int i = 0; printed < options->fds; ++i)
+    {
+      printf(printed++ ? ", " : "");
+      printf("A%d A%d->A%d", n - 1, i % (n - 1), (i + 1) % (n - 1));
+    }
+  }
+  else
+  {
+    fprintf(stderr, "Error: unknown workload '%s'\n", kind);
+    return 1;
+  }
+
+  printf("}\n");
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  GenOptions options = {argv[1], 0, 0, 3, 1000, 1};
+
+  for (int i = 2; i < argc; ++i)
+  {
+    if (i + 1 >= argc)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    if (strcmp(argv[i], "--attrs") == 0)
+      options.attrs = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--fds") == 0)
+      options.fds = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--lhs") == 0)
+      options.lhs = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--count") == 0)
+      options.count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0)
+      options.seed = strtoull(argv[++i], NULL, 10);
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (options.attrs < 3 || options.fds < 0 || options.lhs < 1 || options.count < 0)
+  {
+    fprintf(stderr, "Error: need --attrs >= 3, --lhs >= 1 and non-negative counts\n");
+    return 1;
+  }
+
+  rngState = options.seed;
+  return generate(&options);
+}
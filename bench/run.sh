@@ -0,0 +1,148 @@
+#!/bin/sh
+# -----------------------------------------------------------------------------
+# Benchmarks: gera as cargas com fdgen, mede closure, mincover, keys e
+# normalform em cada uma e grava os tempos em CSV e JSON.
+#
+#   sh bench/run.sh            (ou: make bench)
+#
+# Variáveis de ambiente:
+#   FDTOOL   binário medido              (padrão: ./fdtool)
+#   FDGEN    gerador                     (padrão: ./fdgen)
+#   OUT      diretório dos resultados    (padrão: bench/results)
+#   REPEAT   execuções por medida; vale o menor tempo (padrão: 3)
+#   LIMIT    segundos por execução antes de desistir (padrão: 60)
+#   THREADS  --threads dos modos paralelos (padrão: 4)
+#
+# Cada linha do resultado é uma medida: carga, comando, modo, tempo (s) e
+# estado (ok, timeout ou error). Para comparar duas versões, rode com
+# FDTOOL apontando para cada binário e compare os CSV.
+# -----------------------------------------------------------------------------
+set -u
+
+FDTOOL=${FDTOOL:-./fdtool}
+FDGEN=${FDGEN:-./fdgen}
+OUT=${OUT:-bench/results}
+REPEAT=${REPEAT:-3}
+LIMIT=${LIMIT:-60}
+THREADS=${THREADS:-4}
+
+WORK="$OUT/work"
+CSV="$OUT/results.csv"
+JSON="$OUT/results.json"
+LINES="$WORK/results.jsonl"
+
+mkdir -p "$WORK" || exit 1
+
+# Cargas: nome, tipo e parâmetros do fdgen
+WORKLOADS="
+chain500        chain       --attrs 500
+star500         star        --attrs 500
+random64        random      --attrs 64 --fds 400 --lhs 3 --seed 1
+random200       random      --attrs 200 --fds 2000 --lhs 4 --seed 2
+cycle200        cycle       --attrs 200
+manykeys24      manykeys    --attrs 24
+adversarial200  adversarial --attrs 200 --fds 2000
+deepchain500    deepchain   --attrs 500 --fds 30000
+"
+
+# Comandos medidos em cada carga: comando e opções
+MODES="
+closure         --queries QUERIES
+closure         --queries QUERIES --closure-engine naive
+closure         --queries QUERIES --batch-kernel scalar
+closure         --queries QUERIES --batch-kernel off
+mincover
+mincover        --threads THREADS
+keys            --algo bfs
+keys            --algo bfs --threads THREADS
+keys            --algo lo
+keys            --algo dfs
+normalform
+normalform      --algo lo
+"
+
+now() {
+  date +%s%N
+}
+
+# "nanossegundos código-de-saída" de uma execução
+timeRun() {
+  start=$(now)
+  timeout "$LIMIT" "$@" >/dev/null 2>&1
+  code=$?
+  end=$(now)
+  echo "$((end - start)) $code"
+}
+
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+host=$(uname -n)
+cpus=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+
+echo "workload,kind,attrs,fds,command,options,seconds,status" >"$CSV"
+: >"$LINES"
+
+echo "$WORKLOADS" | while read -r name kind params; do
+  [ -z "$name" ] && continue
+
+  fds="$WORK/$name.fds"
+  queries="$WORK/$name.queries"
+  attrs=$(echo "$params" | sed -n 's/.*--attrs \([0-9]*\).*/\1/p')
+  # shellcheck disable=SC2086
+  if ! "$FDGEN" "$kind" $params >"$fds" ||
+     ! "$FDGEN" queries --attrs "$attrs" --count 20000 --lhs 4 --seed 7 >"$queries"; then
+    echo "Error: cannot generate $name" >&2
+    continue
+  fi
+  fdCount=$(tr ',' '\n' <"$fds" | grep -c -- '->')
+
+  echo "$MODES" | while read -r command options; do
+    [ -z "$command" ] && continue
+    options=$(echo "$options" | sed "s|QUERIES|$queries|; s|THREADS|$THREADS|")
+
+    best=""
+    status=ok
+    i=0
+    while [ $i -lt "$REPEAT" ]; do
+      # shellcheck disable=SC2086
+      result=$(timeRun "$FDTOOL" "$command" --fds "$fds" $options)
+      ns=${result% *}
+      runStatus=${result#* }
+      if [ "$runStatus" -eq 124 ]; then
+        status=timeout
+        best=""
+        break
+      elif [ "$runStatus" -ne 0 ]; then
+        status=error
+        best=""
+        break
+      fi
+      if [ -z "$best" ] || [ "$ns" -lt "$best" ]; then
+        best=$ns
+      fi
+      i=$((i + 1))
+    done
+
+    if [ -n "$best" ]; then
+      seconds=$(printf '%d.%06d' $((best / 1000000000)) $((best % 1000000000 / 1000)))
+    else
+      seconds=""
+    fi
+    shown=$(echo "$options" | sed "s|$queries|<queries>|")
+
+    printf '%-16s %-11s %-48s %10s %s\n' "$name" "$command" "$shown" "${seconds:--}" "$status"
+    echo "$name,$kind,$attrs,$fdCount,$command,$shown,$seconds,$status" >>"$CSV"
+    printf '{"workload": "%s", "kind": "%s", "attrs": %s, "fds": %s, "command": "%s", "options": "%s", "seconds": %s, "status": "%s"}\n' \
+      "$name" "$kind" "$attrs" "$fdCount" "$command" "$shown" "${seconds:-null}" "$status" >>"$LINES"
+  done
+done
+
+# Os laços rodam em subshells (pipes): o JSON é montado no fim, a partir de
+# um objeto por linha
+{
+  printf '{\n  "commit": "%s",\n  "host": "%s",\n  "cpus": %s,\n' "$commit" "$host" "$cpus"
+  printf '  "repeat": %s,\n  "limit": %s,\n  "results": [\n' "$REPEAT" "$LIMIT"
+  sed '$!s/$/,/; s/^/    /' "$LINES"
+  printf '  ]\n}\n'
+} >"$JSON"
+
+echo "Results: $CSV, $JSON"
@@ -1,10 +1,22 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "parser.h"
 #include "closure.h"
 #include "mincover.h"
 #include "keys.h"
 #include "normalform.h"
+#include "analysis.h"
+#include "closurecache.h"
+#include "keyindex.h"
+#include "fdb.h"
+#include "stats.h"
+#include "server.h"
+#include "batch.h"
+#include "catalog.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* ------------------------------------------------------------
    Exibe instruções de uso do programa
@@ -14,12 +26,412 @@ static void printUsage(const char *programName)
   fprintf(stderr,
           "Usage:\n"
           "  %s closure    --fds <file.fds> --X <ATTRS>\n"
-          "  %s mincover   --fds <file.fds>\n"
-          "  %s keys       --fds <file.fds>\n"
-          "  %s normalform --fds <file.fds>\n",
+          "  %s closure    --fds <file.fds> --queries <file|->\n"
+          "  %s mincover   --fds <file.fds> [--threads N]\n"
+          "  %s keys       --fds <file.fds> [--algo bfs|lo|dfs] [--threads N]\n"
+          "                   [--max-keys N] [--time-budget SECONDS]\n"
+          "  %s normalform --fds <file.fds> [--algo bfs|lo|dfs] [--threads N]\n"
+          "  %s analyze    --fds <file.fds> [--algo bfs|lo|dfs] [--threads N]\n"
+          "  %s superkey   --fds <file.fds> (--X <ATTRS> | --queries <file|->)\n"
+          "                   [--algo bfs|lo|dfs] [--threads N]\n"
+          "  %s compile    <file.fds> -o <file.fdb> [--cover] [--keys] [--index] [--all]\n"
+          "                   [--algo bfs|lo|dfs] [--threads N]\n"
+          "  %s serve      --socket <path> [--threads N] [--algo bfs|lo|dfs]\n"
+          "  %s batch      <dir|catalog|list|-> [--jobs N] [--analyses LIST] [--algo bfs|lo|dfs]\n"
+          "  %s catalog    <file>\n"
+          "\n"
+          "Every --fds (and compile's input) also accepts a compiled .fdb file, or a\n"
+          "catalog together with --relation NAME (the relation to analyze).\n"
+          "\n"
+          "Options (all commands):\n"
+          "  --closure-engine linear|naive|table\n"
+          "                                  closure algorithm (default: linear)\n"
+          "  --batch-kernel auto|scalar|avx2|off\n"
+          "                                  bit-sliced kernel for batched closures\n"
+          "                                  (default: auto)\n"
+          "  --cache N                       closure cache entries (default: 4096;\n"
+          "                                  0 = off)\n"
+          "  --stats                         per-phase times, algorithm counters and\n"
+          "                                  peak memory on stderr at exit\n"
+          "  --stats-json FILE               same report as JSON, written to FILE\n"
+          "  --hw-counters                   add cycles, instructions and cache misses\n"
+          "                                  (Linux perf events; implies --stats)\n"
+          "\n"
+          "Options (mincover, keys, normalform, analyze, superkey, compile):\n"
+          "  --threads N                     worker threads for the minimum cover\n"
+          "                                  and the key BFS (default: 1;\n"
+          "                                  0 = one per CPU)\n"
+          "\n"
+          "Options (keys, normalform, analyze, superkey, compile):\n"
+          "  --algo bfs|lo|dfs               key enumeration: breadth-first search,\n"
+          "                                  Lucchesi-Osborn or depth-first search\n"
+          "                                  (default: bfs)\n"
+          "\n"
+          "Options (keys):\n"
+          "  --max-keys N                    stop after N keys\n"
+          "  --time-budget SECONDS           stop after SECONDS of search\n"
+          "                                  (both imply --algo dfs: keys are printed\n"
+          "                                  as found, in search order)\n"
+          "\n"
+          "Options (compile):\n"
+          "  --cover, --keys, --index        also store the minimum cover, the candidate\n"
+          "                                  keys and the closure index (keys and index\n"
+          "                                  imply the cover); --all stores all three\n"
+          "\n"
+          "Options (serve):\n"
+          "  --socket PATH                   Unix socket to listen on; requests are\n"
+          "                                  one per line (see README)\n"
+          "  --threads N                     connections served at once (default:\n"
+          "                                  one per CPU); each request runs on one\n"
+          "                                  thread\n"
+          "\n"
+          "Options (batch):\n"
+          "  <dir|list|->                    every .fds/.fdb in a directory, or a file\n"
+          "                                  (- = stdin) with one path per line;\n"
+          "                                  one JSON line per file on stdout, in\n"
+          "                                  input order\n"
+          "  --jobs N                        files analyzed at once (default: one\n"
+          "                                  per CPU)\n"
+          "  --analyses LIST                 comma-separated: mincover, keys,\n"
+          "                                  normalform (default: all)\n",
+          programName, programName, programName, programName, programName, programName, programName,
           programName, programName, programName, programName);
 }
 
+/* ------------------------------------------------------------
+   Opções aceitas por todos os comandos.
+   Retorna 1 se argv[*i] foi consumido, 0 se não é uma opção
+   comum e -1 se o valor é inválido.
+------------------------------------------------------------ */
+static int parseCommonOption(int argc, char **argv, int *i)
+{
+  if (strcmp(argv[*i], "--closure-engine") == 0 && *i + 1 < argc)
+  {
+    const char *engine = argv[++(*i)];
+
+    if (strcmp(engine, "linear") == 0)
+      setClosureEngine(CLOSURE_ENGINE_LINEAR);
+    else if (strcmp(engine, "naive") == 0)
+      setClosureEngine(CLOSURE_ENGINE_NAIVE);
+    else if (strcmp(engine, "table") == 0)
+      setClosureEngine(CLOSURE_ENGINE_TABLE);
+    else
+    {
+      fprintf(stderr, "Error: unknown closure engine '%s'\n", engine);
+      return -1;
+    }
+    return 1;
+  }
+
+  if (strcmp(argv[*i], "--cache") == 0 && *i + 1 < argc)
+  {
+    const char *value = argv[++(*i)];
+    char *end;
+    long entries = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || entries < 0)
+    {
+      fprintf(stderr, "Error: invalid cache size '%s'\n", value);
+      return -1;
+    }
+    setClosureCacheEntries((size_t)entries);
+    return 1;
+  }
+
+  if (strcmp(argv[*i], "--stats") == 0)
+  {
+    setStatsEnabled(1);
+    return 1;
+  }
+
+  if (strcmp(argv[*i], "--stats-json") == 0 && *i + 1 < argc)
+  {
+    setStatsEnabled(1);
+    setStatsJsonPath(argv[++(*i)]);
+    return 1;
+  }
+
+  if (strcmp(argv[*i], "--hw-counters") == 0)
+  {
+    setStatsEnabled(1);
+    setStatsHardwareCounters(1);
+    return 1;
+  }
+
+  if (strcmp(argv[*i], "--batch-kernel") == 0 && *i + 1 < argc)
+  {
+    const char *kernel = argv[++(*i)];
+
+    if (strcmp(kernel, "auto") == 0)
+      setClosureBatchKernel(CLOSURE_BATCH_AUTO);
+    else if (strcmp(kernel, "scalar") == 0)
+      setClosureBatchKernel(CLOSURE_BATCH_SCALAR);
+    else if (strcmp(kernel, "avx2") == 0)
+      setClosureBatchKernel(CLOSURE_BATCH_AVX2);
+    else if (strcmp(kernel, "off") == 0)
+      setClosureBatchKernel(CLOSURE_BATCH_OFF);
+    else
+    {
+      fprintf(stderr, "Error: unknown batch kernel '%s'\n", kernel);
+      return -1;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+/* ------------------------------------------------------------
+   Opções dos comandos que calculam a cobertura mínima
+   (mincover, keys, normalform, analyze).
+   Mesma convenção de retorno de parseCommonOption.
+------------------------------------------------------------ */
+static int parseThreadOption(int argc, char **argv, int *i)
+{
+  if (strcmp(argv[*i], "--threads") == 0 && *i + 1 < argc)
+  {
+    char *end;
+    long threads = strtol(argv[++(*i)], &end, 10);
+
+    if (*end != '\0' || threads < 0 || threads > 1024)
+    {
+      fprintf(stderr, "Error: invalid thread count '%s'\n", argv[*i]);
+      return -1;
+    }
+    setMinCoverThreads((int)threads);
+    setKeyThreads((int)threads);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* ------------------------------------------------------------
+   Opções dos comandos que enumeram chaves (keys, normalform,
+   analyze).
+   Mesma convenção de retorno de parseCommonOption.
+------------------------------------------------------------ */
+static int parseKeyOption(int argc, char **argv, int *i)
+{
+  if (strcmp(argv[*i], "--algo") == 0 && *i + 1 < argc)
+  {
+    const char *algo = argv[++(*i)];
+
+    if (strcmp(algo, "bfs") == 0)
+      setKeyAlgorithm(KEYS_ALGO_BFS);
+    else if (strcmp(algo, "lo") == 0)
+      setKeyAlgorithm(KEYS_ALGO_LO);
+    else if (strcmp(algo, "dfs") == 0)
+      setKeyAlgorithm(KEYS_ALGO_DFS);
+    else
+    {
+      fprintf(stderr, "Error: unknown key algorithm '%s'\n", algo);
+      return -1;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Lista do --analyses do batch ("mincover,keys"); -1 se inválida */
+static int parseBatchAnalyses(const char *list)
+{
+  int analyses = 0;
+
+  while (*list)
+  {
+    size_t length = strcspn(list, ",");
+    if (length == 8 && strncmp(list, "mincover", length) == 0)
+      analyses |= BATCH_MINCOVER;
+    else if (length == 4 && strncmp(list, "keys", length) == 0)
+      analyses |= BATCH_KEYS;
+    else if (length == 10 && strncmp(list, "normalform", length) == 0)
+      analyses |= BATCH_NORMALFORM;
+    else
+      return -1;
+
+    list += length;
+    if (*list == ',')
+      list++;
+  }
+
+  return analyses ? analyses : -1;
+}
+
+/* Saída da enumeração em fluxo: cada chave sai assim que é achada */
+static int printStreamedKey(attrset key, void *context)
+{
+  printAttrsetCompact(context, key);
+  printf("\n");
+  fflush(stdout);
+  return 0;
+}
+
+static double elapsedSeconds(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* ------------------------------------------------------------
+   Consultas de fecho em lote: um conjunto X por linha, um fecho
+   por linha na saída. O índice é montado uma vez e a saída é
+   bufferizada. Uma linha com nomes fora do esquema recebe um
+   erro no lugar do fecho, e o comando termina com 1.
+------------------------------------------------------------ */
+static int runClosureQueries(const char *queriesPath, AttrDict *dict,
+                             ClosureIndex *closureIndex, int showStats)
+{
+  FILE *in = strcmp(queriesPath, "-") == 0 ? stdin : fopen(queriesPath, "r");
+  if (!in)
+  {
+    fprintf(stderr, "Error: cannot read %s\n", queriesPath);
+    return 1;
+  }
+
+  static char outputBuffer[1 << 16];
+  setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  /* Consultas repetidas saem do cache */
+  size_t cacheEntries = getClosureCacheEntries();
+  ClosureCache *cache = cacheEntries > 0 ? createClosureCache(cacheEntries) : NULL;
+
+  /* Consultas são lidas em blocos e fechadas juntas */
+  enum { QUERY_BLOCK = 256 };
+  attrset block[QUERY_BLOCK];
+  char *unknown[QUERY_BLOCK]; // linha da consulta inválida (NULL = válida)
+  int blockCount = 0;
+
+  char *line = NULL;
+  size_t lineCapacity = 0;
+  long queryCount = 0;
+  int failed = 0;
+  int done = 0;
+
+  while (!done)
+  {
+    if (getline(&line, &lineCapacity, in) >= 0)
+    {
+      line[strcspn(line, "\r\n")] = '\0';
+      unknown[blockCount] = NULL;
+      if (attrsetFromKnownNames(dict, line, &block[blockCount]) != 0)
+      {
+        block[blockCount] = attrsetEmpty();
+        unknown[blockCount] = strdup(line);
+        failed = 1;
+      }
+      blockCount++;
+    }
+    else
+      done = 1;
+
+    if (blockCount == QUERY_BLOCK || (done && blockCount > 0))
+    {
+      if (cache)
+        cachedClosureBatch(cache, closureIndex, block, block, blockCount, 1);
+      else
+        computeClosureBatch(closureIndex, block, block, blockCount);
+
+      for (int q = 0; q < blockCount; ++q)
+      {
+        if (unknown[q])
+          printf("Error: unknown attributes in %s\n", unknown[q]);
+        else
+        {
+          fprintAttrset(stdout, dict, block[q]);
+          putchar('\n');
+        }
+        free(unknown[q]);
+      }
+
+      queryCount += blockCount;
+      blockCount = 0;
+    }
+  }
+
+  fflush(stdout);
+  free(line);
+  if (in != stdin)
+    fclose(in);
+
+  if (showStats)
+  {
+    double seconds = elapsedSeconds(&start);
+    fprintf(stderr, "closure: %ld queries in %.3f s (%.0f queries/sec)\n",
+            queryCount, seconds, seconds > 0 ? queryCount / seconds : 0.0);
+    if (cache)
+      fprintClosureCacheStats(stderr, "closure", cache);
+  }
+
+  freeClosureCache(cache);
+
+  return failed;
+}
+
+/* ------------------------------------------------------------
+   Veredicto de superchave para X: "key", "superkey <K>" com uma
+   chave K ⊆ X, ou "not a superkey"
+------------------------------------------------------------ */
+static void printSuperkeyVerdict(AttrDict *dict, const KeyIndex *keyIndex, attrset X)
+{
+  attrset key;
+  if (!keyIndexFindSubset(keyIndex, X, &key))
+    printf("not a superkey\n");
+  else if (attrsetEquals(key, X))
+    printf("key\n");
+  else
+  {
+    printf("superkey ");
+    printAttrsetCompact(dict, key);
+    printf("\n");
+  }
+}
+
+/* ------------------------------------------------------------
+   Consultas de superchave em lote: um conjunto X por linha, um
+   veredicto por linha na saída. Cada consulta só percorre os
+   ramos do índice de chaves contidos em X, sem fechos. Como no
+   closure, nomes fora do esquema dão erro na linha e código 1.
+------------------------------------------------------------ */
+static int runSuperkeyQueries(const char *queriesPath, AttrDict *dict, const KeyIndex *keyIndex)
+{
+  FILE *in = strcmp(queriesPath, "-") == 0 ? stdin : fopen(queriesPath, "r");
+  if (!in)
+  {
+    fprintf(stderr, "Error: cannot read %s\n", queriesPath);
+    return 1;
+  }
+
+  static char outputBuffer[1 << 16];
+  setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+  char *line = NULL;
+  size_t lineCapacity = 0;
+  int failed = 0;
+  while (getline(&line, &lineCapacity, in) >= 0)
+  {
+    line[strcspn(line, "\r\n")] = '\0';
+    attrset X;
+    if (attrsetFromKnownNames(dict, line, &X) == 0)
+      printSuperkeyVerdict(dict, keyIndex, X);
+    else
+    {
+      printf("Error: unknown attributes in %s\n", line);
+      failed = 1;
+    }
+  }
+
+  fflush(stdout);
+  free(line);
+  if (in != stdin)
+    fclose(in);
+  return failed;
+}
+
 /* ------------------------------------------------------------
    Função principal: interpreta comandos e chama os módulos
 ------------------------------------------------------------ */
@@ -39,14 +451,26 @@ int main(int argc, char **argv)
   if (strcmp(command, "closure") == 0)
   {
     const char *fdsPath = NULL;
+    const char *relation = NULL;
     const char *xString = NULL;
+    const char *queriesPath = NULL;
 
     for (int i = 2; i < argc; ++i)
     {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
       if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
         fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
       else if (strcmp(argv[i], "--X") == 0 && i + 1 < argc)
         xString = argv[++i];
+      else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+        queriesPath = argv[++i];
       else
       {
         printUsage(argv[0]);
@@ -54,22 +478,35 @@ int main(int argc, char **argv)
       }
     }
 
-    if (!fdsPath || !xString)
+    if (!fdsPath || !xString == !queriesPath)
     {
       printUsage(argv[0]);
       return 1;
     }
 
-    attrset universe = 0;
-    int fdCount = 0;
-    FD *fds = parseFdsFile(fdsPath, &universe, &fdCount);
-    if (!fds)
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
+      return 1;
+
+    /* O índice gravado é sobre a cobertura: mesmos fechos */
+    ClosureIndex *closureIndex = schema.closureIndex;
+    if (!closureIndex)
+      closureIndex = buildMergedClosureIndex(schema.fds, schema.fdCount);
+    if (!closureIndex)
       return 1;
 
-    attrset X = attrsetFromString(xString);
-    attrset closure = computeClosure(X, fds, fdCount);
+    if (queriesPath)
+      return runClosureQueries(queriesPath, &dict, closureIndex, getStatsEnabled());
 
-    printAttrsetCompact(closure);
+    attrset X = attrsetFromString(&dict, xString);
+    attrset closure = computeClosureIndexed(closureIndex, X);
+
+    printAttrsetCompact(&dict, closure);
     printf("\n");
     return 0;
   }
@@ -80,11 +517,22 @@ int main(int argc, char **argv)
   else if (strcmp(command, "mincover") == 0)
   {
     const char *fdsPath = NULL;
+    const char *relation = NULL;
 
     for (int i = 2; i < argc; ++i)
     {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
       if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
         fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
       else
       {
         printUsage(argv[0]);
@@ -92,20 +540,25 @@ int main(int argc, char **argv)
       }
     }
 
-    attrset universe = 0;
-    int fdCount = 0;
-    FD *fds = parseFdsFile(fdsPath, &universe, &fdCount);
-    if (!fds)
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
       return 1;
 
-    int minCount = 0;
-    FD *minCover = computeMinimumCover(fds, fdCount, &minCount);
+    int minCount = schema.coverCount;
+    FD *minCover = schema.cover;
+    if (!minCover)
+      minCover = computeMinimumCover(schema.fds, schema.fdCount, &minCount);
 
     for (int i = 0; i < minCount; ++i)
     {
-      printAttrsetCompact(minCover[i].lhs);
+      printAttrsetCompact(&dict, minCover[i].lhs);
       printf("->");
-      printAttrsetCompact(minCover[i].rhs);
+      printAttrsetCompact(&dict, minCover[i].rhs);
       printf("\n");
     }
     return 0;
@@ -117,11 +570,45 @@ int main(int argc, char **argv)
   else if (strcmp(command, "keys") == 0)
   {
     const char *fdsPath = NULL;
+    const char *relation = NULL;
+    KeyLimits limits = {0, 0};
 
     for (int i = 2; i < argc; ++i)
     {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
       if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
         fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
+      else if (strcmp(argv[i], "--max-keys") == 0 && i + 1 < argc)
+      {
+        limits.maxKeys = atol(argv[++i]);
+        if (limits.maxKeys <= 0)
+        {
+          fprintf(stderr, "Error: invalid key limit '%s'\n", argv[i]);
+          return 1;
+        }
+        setKeyAlgorithm(KEYS_ALGO_DFS);
+      }
+      else if (strcmp(argv[i], "--time-budget") == 0 && i + 1 < argc)
+      {
+        limits.timeBudget = atof(argv[++i]);
+        if (limits.timeBudget <= 0)
+        {
+          fprintf(stderr, "Error: invalid time budget '%s'\n", argv[i]);
+          return 1;
+        }
+        setKeyAlgorithm(KEYS_ALGO_DFS);
+      }
       else
       {
         printUsage(argv[0]);
@@ -129,21 +616,48 @@ int main(int argc, char **argv)
       }
     }
 
-    attrset universe = 0;
-    int fdCount = 0;
-    FD *fds = parseFdsFile(fdsPath, &universe, &fdCount);
-    if (!fds)
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
       return 1;
 
-    int minCount = 0;
-    FD *minCover = computeMinimumCover(fds, fdCount, &minCount);
+    int minCount = schema.coverCount;
+    FD *minCover = schema.cover;
+    if (!minCover)
+      minCover = computeMinimumCover(schema.fds, schema.fdCount, &minCount);
 
-    int keyCount = 0;
-    attrset *keys = computeCandidateKeys(universe, minCover, minCount, &keyCount);
+    /* DFS: as chaves saem em fluxo, na ordem da busca */
+    if (getKeyAlgorithm() == KEYS_ALGO_DFS)
+    {
+      long found = 0;
+      KeyEnumStatus status = enumerateCandidateKeys(schema.U, minCover, minCount, &limits,
+                                                    printStreamedKey, &dict, &found);
+      if (status == KEYS_FAILED)
+      {
+        fprintf(stderr, "Error: out of memory enumerating keys\n");
+        return 1;
+      }
+      if (status == KEYS_KEY_LIMIT)
+        fprintf(stderr, "Stopped after %ld keys: key limit reached\n", found);
+      else if (status == KEYS_TIME_LIMIT)
+        fprintf(stderr, "Stopped after %ld keys: time budget exhausted\n", found);
+      return 0;
+    }
+
+    int keyCount = schema.keyCount;
+    attrset *keys = schema.keys;
+    if (!keys)
+      keys = computeCandidateKeys(schema.U, minCover, minCount, &keyCount);
+    if (!keys)
+      return 1;
 
     for (int i = 0; i < keyCount; ++i)
     {
-      printAttrsetCompact(keys[i]);
+      printAttrsetCompact(&dict, keys[i]);
       printf("\n");
     }
     return 0;
@@ -155,11 +669,79 @@ int main(int argc, char **argv)
   else if (strcmp(command, "normalform") == 0)
   {
     const char *fdsPath = NULL;
+    const char *relation = NULL;
+
+    for (int i = 2; i < argc; ++i)
+    {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
+      if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
+        fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
+      return 1;
+
+    AnalysisContext ctx;
+    initAnalysisContext(&ctx, schema.U, schema.fds, schema.fdCount);
+    analysisUsePrecomputed(&ctx, schema.cover, schema.coverCount, schema.closureIndex, schema.keys,
+                           schema.keyCount);
+    printNormalForms(&dict, &ctx);
+
+    if (getStatsEnabled() && analysisClosureCache(&ctx))
+      fprintClosureCacheStats(stderr, "normalform", analysisClosureCache(&ctx));
+
+    freeAnalysisContext(&ctx);
+    return 0;
+  }
+
+  /* --------------------------------------------------------
+     Comando: ANALYZE
+     Relatório completo (cobertura, chaves, formas normais) com
+     um só parse e cada resultado calculado uma única vez.
+  -------------------------------------------------------- */
+  else if (strcmp(command, "analyze") == 0)
+  {
+    const char *fdsPath = NULL;
+    const char *relation = NULL;
 
     for (int i = 2; i < argc; ++i)
     {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
       if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
         fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
       else
       {
         printUsage(argv[0]);
@@ -167,13 +749,389 @@ int main(int argc, char **argv)
       }
     }
 
-    attrset universe = 0;
-    int fdCount = 0;
-    FD *fds = parseFdsFile(fdsPath, &universe, &fdCount);
-    if (!fds)
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
       return 1;
 
-    checkNormalForms(universe, fds, fdCount);
+    AnalysisContext ctx;
+    initAnalysisContext(&ctx, schema.U, schema.fds, schema.fdCount);
+    analysisUsePrecomputed(&ctx, schema.cover, schema.coverCount, schema.closureIndex, schema.keys,
+                           schema.keyCount);
+
+    int minCount = 0;
+    const FD *minCover = analysisCover(&ctx, &minCount);
+
+    printf("Minimum cover (%d):\n", minCount);
+    for (int i = 0; i < minCount; ++i)
+    {
+      printAttrsetCompact(&dict, minCover[i].lhs);
+      printf("->");
+      printAttrsetCompact(&dict, minCover[i].rhs);
+      printf("\n");
+    }
+
+    int keyCount = 0;
+    const attrset *keys = analysisKeys(&ctx, &keyCount);
+
+    printf("Candidate keys (%d):\n", keyCount);
+    for (int i = 0; i < keyCount; ++i)
+    {
+      printAttrsetCompact(&dict, keys[i]);
+      printf("\n");
+    }
+
+    printf("Prime attributes: ");
+    printAttrsetCompact(&dict, analysisPrimeAttributes(&ctx));
+    printf("\n");
+
+    printNormalForms(&dict, &ctx);
+
+    if (getStatsEnabled() && analysisClosureCache(&ctx))
+      fprintClosureCacheStats(stderr, "analyze", analysisClosureCache(&ctx));
+
+    int failed = analysisFailed(&ctx);
+    freeAnalysisContext(&ctx);
+    if (failed)
+    {
+      fprintf(stderr, "Error: out of memory\n");
+      return 1;
+    }
+    return 0;
+  }
+
+  /* --------------------------------------------------------
+     Comando: COMPILE
+  -------------------------------------------------------- */
+  else if (strcmp(command, "compile") == 0)
+  {
+    const char *fdsPath = NULL;
+    const char *relation = NULL;
+    const char *outPath = NULL;
+    int withCover = 0, withKeys = 0, withIndex = 0;
+
+    for (int i = 2; i < argc; ++i)
+    {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
+      if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
+        fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
+      else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        outPath = argv[++i];
+      else if (strcmp(argv[i], "--cover") == 0)
+        withCover = 1;
+      else if (strcmp(argv[i], "--keys") == 0)
+        withKeys = 1;
+      else if (strcmp(argv[i], "--index") == 0)
+        withIndex = 1;
+      else if (strcmp(argv[i], "--all") == 0)
+        withCover = withKeys = withIndex = 1;
+      else if (argv[i][0] != '-' && !fdsPath)
+        fdsPath = argv[i];
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    if (!fdsPath || !outPath)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
+      return 1;
+
+    /* Chaves e índice são calculados sobre a cobertura */
+    FdSchema compiled = schema;
+    compiled.cover = NULL;
+    compiled.keys = NULL;
+    compiled.closureIndex = NULL;
+
+    if (withCover || withKeys || withIndex)
+    {
+      compiled.cover = schema.cover;
+      compiled.coverCount = schema.coverCount;
+      if (!compiled.cover)
+        compiled.cover = computeMinimumCover(schema.fds, schema.fdCount, &compiled.coverCount);
+
+      /* Cobertura vazia volta como NULL; no arquivo é uma seção vazia */
+      static FD emptyCover[1];
+      if (!compiled.cover)
+        compiled.cover = emptyCover;
+    }
+
+    if (withKeys)
+    {
+      compiled.keys = schema.keys;
+      compiled.keyCount = schema.keyCount;
+      if (!compiled.keys)
+        compiled.keys = computeCandidateKeys(schema.U, compiled.cover, compiled.coverCount, &compiled.keyCount);
+    }
+
+    if (withIndex)
+    {
+      compiled.closureIndex = schema.closureIndex;
+      if (!compiled.closureIndex)
+        compiled.closureIndex = buildMergedClosureIndex(compiled.cover, compiled.coverCount);
+    }
+
+    if (withKeys && !compiled.keys)
+      return 1;
+    if (withIndex && !compiled.closureIndex)
+    {
+      fprintf(stderr, "Error: out of memory\n");
+      return 1;
+    }
+
+    return writeFdbFile(outPath, &dict, &compiled) == 0 ? 0 : 1;
+  }
+
+  /* --------------------------------------------------------
+     Comando: SUPERKEY
+  -------------------------------------------------------- */
+  else if (strcmp(command, "superkey") == 0)
+  {
+    const char *fdsPath = NULL;
+    const char *relation = NULL;
+    const char *xString = NULL;
+    const char *queriesPath = NULL;
+
+    for (int i = 2; i < argc; ++i)
+    {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
+      if (strcmp(argv[i], "--fds") == 0 && i + 1 < argc)
+        fdsPath = argv[++i];
+      else if (strcmp(argv[i], "--relation") == 0 && i + 1 < argc)
+        relation = argv[++i];
+      else if (strcmp(argv[i], "--X") == 0 && i + 1 < argc)
+        xString = argv[++i];
+      else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+        queriesPath = argv[++i];
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    if (!fdsPath || !xString == !queriesPath)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    AttrDict dict;
+    initAttrDict(&dict);
+
+    startStats(command);
+
+    FdSchema schema;
+    if (loadSchemaRelation(fdsPath, relation, &dict, &schema) != 0)
+      return 1;
+
+    AnalysisContext ctx;
+    initAnalysisContext(&ctx, schema.U, schema.fds, schema.fdCount);
+    analysisUsePrecomputed(&ctx, schema.cover, schema.coverCount, schema.closureIndex, schema.keys,
+                           schema.keyCount);
+
+    /* X é superchave sse contém alguma chave candidata */
+    int keyCount = 0;
+    const attrset *keys = analysisKeys(&ctx, &keyCount);
+
+    KeyIndex keyIndex;
+    int failed = analysisFailed(&ctx) || initKeyIndex(&keyIndex) != 0;
+    for (int k = 0; k < keyCount && !failed; ++k)
+      failed = keyIndexInsert(&keyIndex, keys[k]) != 0;
+    freeAnalysisContext(&ctx);
+
+    if (failed)
+    {
+      fprintf(stderr, "Error: out of memory\n");
+      return 1;
+    }
+
+    int status = 0;
+    if (queriesPath)
+      status = runSuperkeyQueries(queriesPath, &dict, &keyIndex);
+    else
+      printSuperkeyVerdict(&dict, &keyIndex, attrsetFromString(&dict, xString));
+
+    freeKeyIndex(&keyIndex);
+    return status;
+  }
+
+  /* --------------------------------------------------------
+     Comando: SERVE
+     Processo residente: esquemas carregados uma vez, pedidos
+     por um socket Unix.
+  -------------------------------------------------------- */
+  else if (strcmp(command, "serve") == 0)
+  {
+    const char *socketPath = NULL;
+
+    /* --threads aqui é o número de conexões atendidas juntas
+       (padrão: uma por CPU); cada pedido roda numa thread só */
+    setMinCoverThreads(0);
+
+    for (int i = 2; i < argc; ++i)
+    {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseThreadOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
+      if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        socketPath = argv[++i];
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    if (!socketPath)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    int workers = getMinCoverThreads();
+    setMinCoverThreads(1);
+    setKeyThreads(1);
+
+    startStats(command);
+    return runServer(socketPath, workers) == 0 ? 0 : 1;
+  }
+
+  /* --------------------------------------------------------
+     Comando: BATCH
+     Muitos esquemas num processo só: leitura adiantada numa
+     thread, análises em --jobs threads, saída JSONL em ordem.
+  -------------------------------------------------------- */
+  else if (strcmp(command, "batch") == 0)
+  {
+    const char *inputPath = NULL;
+    int jobs = 0;
+    int analyses = BATCH_ALL;
+
+    for (int i = 2; i < argc; ++i)
+    {
+      int common = parseCommonOption(argc, argv, &i);
+      if (common == 0)
+        common = parseKeyOption(argc, argv, &i);
+      if (common < 0)
+        return 1;
+      if (common > 0)
+        continue;
+
+      if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+      {
+        char *end;
+        long value = strtol(argv[++i], &end, 10);
+        if (*argv[i] == '\0' || *end != '\0' || value < 0 || value > 1024)
+        {
+          fprintf(stderr, "Error: invalid job count '%s'\n", argv[i]);
+          return 1;
+        }
+        jobs = (int)value;
+      }
+      else if (strcmp(argv[i], "--analyses") == 0 && i + 1 < argc)
+      {
+        analyses = parseBatchAnalyses(argv[++i]);
+        if (analyses < 0)
+        {
+          fprintf(stderr, "Error: invalid analyses '%s'\n", argv[i]);
+          return 1;
+        }
+      }
+      else if ((argv[i][0] != '-' || strcmp(argv[i], "-") == 0) && !inputPath)
+        inputPath = argv[i];
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+
+    if (!inputPath)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    /* O paralelismo é entre arquivos: cada análise roda numa thread */
+    setMinCoverThreads(1);
+    setKeyThreads(1);
+
+    startStats(command);
+    return runBatch(inputPath, jobs, analyses, stdout) == 0 ? 0 : 1;
+  }
+
+  /* --------------------------------------------------------
+     Comando: CATALOG
+     Lista as relações de um catálogo.
+  -------------------------------------------------------- */
+  else if (strcmp(command, "catalog") == 0)
+  {
+    if (argc != 3)
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+
+    Catalog catalog;
+    if (loadCatalog(argv[2], NULL, &catalog) != 0)
+      return 1;
+
+    for (int r = 0; r < catalog.count; ++r)
+    {
+      const CatalogRelation *relation = &catalog.relations[r];
+      printf("%s (%d attributes, %d dependencies):", relation->name, relation->attributeCount,
+             relation->fdCount);
+      for (int a = 0; a < relation->attributeCount; ++a)
+        printf(" %s", catalog.names.names[relation->attributes[a]]);
+      printf("\n");
+    }
+    printf("%d relations, %d distinct attributes\n", catalog.count, catalog.names.count);
+
+    freeCatalog(&catalog);
     return 0;
   }
 
@@ -0,0 +1,199 @@
+#include "analysis.h"
+#include "mincover.h"
+#include "keys.h"
+#include <stdlib.h>
+#include <string.h>
+
+void initAnalysisContext(AnalysisContext *ctx, attrset U, FD *fds, int fdCount)
+{
+  memset(ctx, 0, sizeof(AnalysisContext));
+  ctx->U = U;
+  ctx->fds = fds;
+  ctx->fdCount = fdCount;
+  ctx->attrWords = activeAttrsetWords();
+}
+
+void freeAnalysisContext(AnalysisContext *ctx)
+{
+  if (!ctx->borrowedCover)
+    free(ctx->cover);
+  if (!ctx->borrowedCoverIndex)
+    freeClosureIndex(ctx->coverIndex);
+  freeClosureCache(ctx->closureCache);
+  free(ctx->lhsClosures);
+  if (!ctx->borrowedKeys)
+    free(ctx->keys);
+  memset(ctx, 0, sizeof(AnalysisContext));
+}
+
+void analysisUsePrecomputed(AnalysisContext *ctx, FD *cover, int coverCount, ClosureIndex *coverIndex,
+                            attrset *keys, int keyCount)
+{
+  if (cover)
+  {
+    ctx->cover = cover;
+    ctx->coverCount = coverCount;
+    ctx->haveCover = 1;
+    ctx->borrowedCover = 1;
+  }
+
+  /* O índice só vale junto com a cobertura sobre a qual foi montado */
+  if (cover && coverIndex)
+  {
+    ctx->coverIndex = coverIndex;
+    ctx->borrowedCoverIndex = 1;
+  }
+
+  if (keys)
+  {
+    ctx->keys = keys;
+    ctx->keyCount = keyCount;
+    ctx->haveKeys = 1;
+    ctx->borrowedKeys = 1;
+  }
+}
+
+int analysisFailed(const AnalysisContext *ctx)
+{
+  return ctx->failed;
+}
+
+const FD *analysisCover(AnalysisContext *ctx, int *outCount)
+{
+  if (!ctx->haveCover)
+  {
+    ctx->cover = computeMinimumCover(ctx->fds, ctx->fdCount, &ctx->coverCount);
+    ctx->haveCover = 1;
+  }
+
+  *outCount = ctx->coverCount;
+  return ctx->cover;
+}
+
+ClosureIndex *analysisCoverIndex(AnalysisContext *ctx)
+{
+  if (!ctx->coverIndex)
+  {
+    int coverCount;
+    const FD *cover = analysisCover(ctx, &coverCount);
+
+    ctx->coverIndex = buildMergedClosureIndex(cover, coverCount);
+    if (!ctx->coverIndex)
+      ctx->failed = 1;
+  }
+
+  return ctx->coverIndex;
+}
+
+ClosureCache *analysisClosureCache(AnalysisContext *ctx)
+{
+  if (!ctx->haveClosureCache)
+  {
+    size_t entries = getClosureCacheEntries();
+    if (entries > 0)
+      ctx->closureCache = createClosureCache(entries);
+    ctx->haveClosureCache = 1;
+  }
+
+  return ctx->closureCache;
+}
+
+void analysisReleaseClosureCache(AnalysisContext *ctx)
+{
+  freeClosureCache(ctx->closureCache);
+  ctx->closureCache = NULL;
+  ctx->haveClosureCache = 1;
+}
+
+const attrset *analysisLhsClosures(AnalysisContext *ctx)
+{
+  if (ctx->lhsClosures)
+    return ctx->lhsClosures;
+
+  int coverCount;
+  const FD *cover = analysisCover(ctx, &coverCount);
+  ClosureIndex *closureIndex = analysisCoverIndex(ctx);
+  if (!closureIndex)
+    return NULL;
+
+  ctx->lhsClosures = malloc(sizeof(attrset) * (coverCount > 0 ? coverCount : 1));
+  if (!ctx->lhsClosures)
+  {
+    ctx->failed = 1;
+    return NULL;
+  }
+
+  /* Todos os fechos de uma vez, em lote, com as threads da cobertura;
+     LHS repetidos (RHS unitários) saem do cache */
+  for (int i = 0; i < coverCount; ++i)
+    ctx->lhsClosures[i] = cover[i].lhs;
+
+  ClosureCache *cache = analysisClosureCache(ctx);
+  if (cache)
+    cachedClosureBatch(cache, closureIndex, ctx->lhsClosures, ctx->lhsClosures, coverCount,
+                       getMinCoverThreads());
+  else
+    computeClosureBatchParallel(closureIndex, ctx->lhsClosures, ctx->lhsClosures, coverCount,
+                                getMinCoverThreads());
+
+  return ctx->lhsClosures;
+}
+
+const attrset *analysisKeys(AnalysisContext *ctx, int *outCount)
+{
+  if (!ctx->haveKeys)
+  {
+    int coverCount;
+    const FD *cover = analysisCover(ctx, &coverCount);
+
+    ctx->keys = computeCandidateKeys(ctx->U, cover, coverCount, &ctx->keyCount);
+    if (!ctx->keys)
+      ctx->failed = 1;
+    ctx->haveKeys = 1;
+  }
+
+  *outCount = ctx->keyCount;
+  return ctx->keys;
+}
+
+attrset analysisPrimeAttributes(AnalysisContext *ctx)
+{
+  if (!ctx->havePrime)
+  {
+    int keyCount;
+    const attrset *keys = analysisKeys(ctx, &keyCount);
+
+    ctx->primeAttributes = attrsetEmpty();
+    for (int i = 0; i < keyCount; ++i)
+      ctx->primeAttributes = attrsetUnion(ctx->primeAttributes, keys[i]);
+    ctx->havePrime = 1;
+  }
+
+  return ctx->primeAttributes;
+}
+
+int analysisIsPrime(AnalysisContext *ctx, int a)
+{
+  if (ctx->havePrime)
+    return attrsetHas(ctx->primeAttributes, a);
+
+  if (!attrsetHas(ctx->primeDecided, a))
+  {
+    int coverCount;
+    const FD *cover = analysisCover(ctx, &coverCount);
+    ClosureIndex *closureIndex = analysisCoverIndex(ctx);
+    if (!closureIndex)
+      return 0;
+
+    PrimeVerdict verdict = primeAttributeOracle(ctx->U, cover, coverCount, closureIndex,
+                                                analysisClosureCache(ctx), a);
+    if (verdict == PRIME_UNKNOWN)
+      return attrsetHas(analysisPrimeAttributes(ctx), a);
+
+    attrsetInsert(&ctx->primeDecided, a);
+    if (verdict == PRIME_YES)
+      attrsetInsert(&ctx->primeByOracle, a);
+  }
+
+  return attrsetHas(ctx->primeByOracle, a);
+}
@@ -0,0 +1,103 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "parser.h"
+#include "closure.h"
+#include "closurecache.h"
+
+/* -----------------------------------------------------------------------------
+   Contexto de análise de um esquema: guarda os resultados intermediários
+   compartilhados entre cobertura mínima, chaves e formas normais.
+
+   Cada resultado é calculado na primeira vez que é pedido, a partir dos
+   anteriores, e reaproveitado depois:
+       FDs -> cobertura mínima -> índice da cobertura -> fechos dos LHS
+                               -> chaves candidatas  -> atributos primos
+                               -> oráculo de primos (por atributo)
+
+   Os fechos dos LHS e os do oráculo passam por um cache de fechos do
+   contexto: LHS repetidos na cobertura e as buscas do oráculo para
+   atributos diferentes calculam cada fecho uma só vez.
+
+   As FDs de entrada não pertencem ao contexto (não são liberadas por ele);
+   os demais resultados sim. Os ponteiros devolvidos valem até
+   freeAnalysisContext. Em caso de falta de memória, os getters retornam
+   NULL (ou conjunto vazio) e analysisFailed passa a retornar 1.
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  attrset U;
+  FD *fds;
+  int fdCount;
+
+  /* Largura dos conjuntos do esquema (a ativa na thread quando o contexto
+     foi criado, logo depois da carga): instalar com attrsetUseWords antes
+     de trabalhar sobre o esquema em outra thread */
+  int attrWords;
+
+  int haveCover;
+  FD *cover;
+  int coverCount;
+
+  ClosureIndex *coverIndex;
+
+  /* Fechos sobre a cobertura, compartilhados entre os resultados
+     (NULL com getClosureCacheEntries() == 0) */
+  ClosureCache *closureCache;
+  int haveClosureCache;
+
+  attrset *lhsClosures; // fecho do LHS de cada FD da cobertura
+
+  int haveKeys;
+  attrset *keys;
+  int keyCount;
+
+  int havePrime;
+  attrset primeAttributes;
+
+  /* Respostas do oráculo de atributos primos, por atributo */
+  attrset primeDecided;
+  attrset primeByOracle;
+
+  /* Resultados pré-calculados (analysisUsePrecomputed): não são do contexto */
+  int borrowedCover;
+  int borrowedCoverIndex;
+  int borrowedKeys;
+
+  int failed;
+} AnalysisContext;
+
+void initAnalysisContext(AnalysisContext *ctx, attrset U, FD *fds, int fdCount);
+void freeAnalysisContext(AnalysisContext *ctx);
+
+/* Usa resultados já calculados (ex: de um .fdb) em vez de calculá-los.
+   cover é a cobertura mínima de fds; coverIndex, o índice mesclado sobre
+   ela; keys, as chaves candidatas. NULL = calcular quando pedido. Continuam
+   sendo de quem chama e devem viver até freeAnalysisContext. */
+void analysisUsePrecomputed(AnalysisContext *ctx, FD *cover, int coverCount, ClosureIndex *coverIndex,
+                            attrset *keys, int keyCount);
+
+const FD *analysisCover(AnalysisContext *ctx, int *outCount);
+ClosureIndex *analysisCoverIndex(AnalysisContext *ctx);
+
+// Cache de fechos do contexto (NULL se desligado ou sem memória)
+ClosureCache *analysisClosureCache(AnalysisContext *ctx);
+
+/* Libera o cache de fechos e não cria outro: para contextos que ficam
+   guardados depois de calculados. Os resultados continuam valendo. */
+void analysisReleaseClosureCache(AnalysisContext *ctx);
+
+// Fecho do LHS de cada FD da cobertura, na ordem de analysisCover
+const attrset *analysisLhsClosures(AnalysisContext *ctx);
+
+const attrset *analysisKeys(AnalysisContext *ctx, int *outCount);
+attrset analysisPrimeAttributes(AnalysisContext *ctx);
+
+/* 1 se o atributo a está em alguma chave. Usa os primos já conhecidos, se
+   as chaves foram enumeradas; senão o oráculo de keys, e só enumera as
+   chaves se ele não decidir. */
+int analysisIsPrime(AnalysisContext *ctx, int a);
+
+int analysisFailed(const AnalysisContext *ctx);
+
+#endif
@@ -0,0 +1,158 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cabeçalho do bloco ocupa uma linha de alinhamento inteira
+#define ARENA_HEADER (((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT) * ARENA_ALIGNMENT)
+
+static size_t alignUp(size_t size)
+{
+  return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static char *blockData(ArenaBlock *block)
+{
+  return (char *)block + ARENA_HEADER;
+}
+
+void initArena(Arena *arena, size_t blockSize)
+{
+  memset(arena, 0, sizeof(Arena));
+  arena->blockSize = blockSize > 0 ? alignUp(blockSize) : ARENA_DEFAULT_BLOCK;
+}
+
+void freeArena(Arena *arena)
+{
+  ArenaBlock *block = arena->first;
+  while (block)
+  {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  memset(arena, 0, sizeof(Arena));
+}
+
+static ArenaBlock *newBlock(size_t size)
+{
+  ArenaBlock *block = aligned_alloc(ARENA_ALIGNMENT, ARENA_HEADER + size);
+  if (!block)
+    return NULL;
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+void *arenaAlloc(Arena *arena, size_t size)
+{
+  size = alignUp(size > 0 ? size : 1);
+
+  ArenaBlock *block = arena->current;
+  if (!block || block->size - block->used < size)
+  {
+    /* Próximo bloco já reservado, se couber; senão um novo, encaixado
+       logo depois do atual */
+    ArenaBlock *next = block ? block->next : arena->first;
+    if (!next || next->size < size)
+    {
+      ArenaBlock *created = newBlock(size > arena->blockSize ? size : arena->blockSize);
+      if (!created)
+        return NULL;
+      created->next = next;
+      if (block)
+        block->next = created;
+      else
+        arena->first = created;
+      next = created;
+    }
+
+    next->used = 0;
+    arena->current = block = next;
+  }
+
+  void *result = blockData(block) + block->used;
+  block->used += size;
+  arena->last = result;
+  return result;
+}
+
+void arenaReset(Arena *arena)
+{
+  arena->current = NULL;
+  arena->last = NULL;
+}
+
+size_t arenaReserved(const Arena *arena)
+{
+  size_t total = 0;
+  for (const ArenaBlock *block = arena->first; block; block = block->next)
+    total += block->size;
+  return total;
+}
+
+/* ---------------------------------------------------------------
+   Rascunho
+---------------------------------------------------------------- */
+static _Thread_local Arena *scratchArena = NULL;
+
+Arena *setScratchArena(Arena *arena)
+{
+  Arena *previous = scratchArena;
+  scratchArena = arena;
+  return previous;
+}
+
+Arena *getScratchArena(void)
+{
+  return scratchArena;
+}
+
+void *scratchAlloc(Arena *arena, size_t size)
+{
+  return arena ? arenaAlloc(arena, size) : malloc(size);
+}
+
+void *scratchCalloc(Arena *arena, size_t count, size_t size)
+{
+  if (!arena)
+    return calloc(count, size);
+
+  if (size > 0 && count > SIZE_MAX / size)
+    return NULL;
+  void *block = arenaAlloc(arena, count * size);
+  if (block)
+    memset(block, 0, count * size);
+  return block;
+}
+
+void *scratchRealloc(Arena *arena, void *block, size_t oldSize, size_t newSize)
+{
+  if (!arena)
+    return realloc(block, newSize);
+
+  /* A última alocação cresce no lugar enquanto couber no bloco */
+  ArenaBlock *current = arena->current;
+  if (block && block == arena->last)
+  {
+    size_t offset = (size_t)((char *)block - blockData(current));
+    size_t grown = alignUp(newSize > 0 ? newSize : 1);
+    if (offset + grown <= current->size)
+    {
+      current->used = offset + grown;
+      return block;
+    }
+  }
+
+  void *moved = arenaAlloc(arena, newSize);
+  if (moved && block)
+    memcpy(moved, block, oldSize < newSize ? oldSize : newSize);
+  return moved;
+}
+
+void scratchFree(Arena *arena, void *block)
+{
+  if (!arena)
+    free(block);
+}
@@ -0,0 +1,66 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------------
+   Arena: alocação por avanço de ponteiro em blocos que nunca são
+   devolvidos ao sistema.
+
+   arenaReset descarta tudo de uma vez em O(1) (volta ao primeiro bloco);
+   os blocos continuam reservados e são reaproveitados nas próximas
+   alocações, então depois que a arena atinge o tamanho de pico não há mais
+   chamadas ao malloc. Alocações maiores que o bloco ganham um bloco só
+   delas, mantido do mesmo jeito. Tudo sai alinhado a ARENA_ALIGNMENT.
+
+   Não é segura entre threads: uma arena por thread.
+ ----------------------------------------------------------------------------- */
+#define ARENA_ALIGNMENT 64
+#define ARENA_DEFAULT_BLOCK (1u << 20)
+
+typedef struct ArenaBlock
+{
+  struct ArenaBlock *next;
+  size_t size;
+  size_t used;
+} ArenaBlock;
+
+typedef struct
+{
+  ArenaBlock *first;
+  ArenaBlock *current;
+  size_t blockSize;
+  void *last; // última alocação (pode crescer no lugar)
+} Arena;
+
+// blockSize 0 = ARENA_DEFAULT_BLOCK. Nenhum bloco é reservado ainda.
+void initArena(Arena *arena, size_t blockSize);
+void freeArena(Arena *arena);
+
+// NULL sem memória
+void *arenaAlloc(Arena *arena, size_t size);
+void arenaReset(Arena *arena);
+
+// Bytes reservados em blocos
+size_t arenaReserved(const Arena *arena);
+
+/* -----------------------------------------------------------------------------
+   Rascunho dos módulos: vetores temporários de uma chamada (filas,
+   conjuntos visitados, máscaras) vêm da arena de rascunho da thread, se
+   houver uma, ou do malloc. Quem aloca guarda a arena do momento
+   (getScratchArena) e a passa também para liberar: com arena, liberar não
+   faz nada, e a memória volta no arenaReset de quem a instalou.
+
+   Memória de rascunho nunca sai da chamada nem passa a outra thread.
+ ----------------------------------------------------------------------------- */
+
+// Instala a arena de rascunho da thread (NULL = malloc); retorna a anterior
+Arena *setScratchArena(Arena *arena);
+Arena *getScratchArena(void);
+
+void *scratchAlloc(Arena *arena, size_t size);
+void *scratchCalloc(Arena *arena, size_t count, size_t size);
+void *scratchRealloc(Arena *arena, void *block, size_t oldSize, size_t newSize);
+void scratchFree(Arena *arena, void *block);
+
+#endif
@@ -0,0 +1,37 @@
+#include "attrset.h"
+
+_Thread_local int attrsetWords = 1;
+
+/* Escolhe a menor largura com caminho dedicado (1, 2 ou 4 palavras) que
+   comporta o universo; acima disso, o número exato de palavras. */
+int attrsetReserve(int attrCount)
+{
+  if (attrCount > ATTRSET_MAX_ATTRS)
+    return -1;
+
+  int needed = (attrCount + 63) / 64;
+  int words;
+
+  if (needed <= 1)
+    words = 1;
+  else if (needed <= 2)
+    words = 2;
+  else if (needed <= 4)
+    words = 4;
+  else
+    words = needed;
+
+  if (words > ATTRSET_MAX_WORDS)
+    words = ATTRSET_MAX_WORDS;
+
+  // Só cresce: as palavras a mais dos conjuntos já criados eram zero
+  if (words > attrsetWords)
+    attrsetWords = words;
+
+  return 0;
+}
+
+void attrsetUseWords(int words)
+{
+  attrsetWords = words;
+}
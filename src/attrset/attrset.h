@@ -0,0 +1,247 @@
+#ifndef ATTRSET_H
+#define ATTRSET_H
+
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+   Conjunto de atributos de largura arbitrária (bitset em palavras de 64 bits).
+
+   A capacidade máxima é fixada em tempo de compilação (ATTRSET_MAX_WORDS),
+   mas as operações só tocam as palavras ativas (attrsetWords), escolhidas em
+   tempo de execução a partir do tamanho do universo. As larguras 1, 2 e 4
+   palavras (64, 128 e 256 bits) têm caminhos próprios, com laço de tamanho
+   constante; as demais usam o laço genérico.
+
+   A largura ativa é da thread: cada esquema guarda a sua (a da carga, em
+   AnalysisContext.attrWords) e quem trabalha sobre ele a instala com
+   attrsetUseWords; threads auxiliares recebem a de quem as criou. Assim um
+   esquema largo carregado em outra thread não alarga os estreitos.
+
+   Palavras acima da largura do esquema são sempre zero.
+ ----------------------------------------------------------------------------- */
+
+#ifndef ATTRSET_MAX_WORDS
+#define ATTRSET_MAX_WORDS 8
+#endif
+
+#define ATTRSET_MAX_ATTRS (ATTRSET_MAX_WORDS * 64)
+
+typedef struct
+{
+  uint64_t w[ATTRSET_MAX_WORDS];
+} attrset;
+
+/* Palavras ativas da thread. Na carga só cresce, então conjuntos criados
+   antes continuam válidos (as palavras novas já eram zero). Initial-exec:
+   as operações leem a largura a cada chamada, também na libfdtool.so. */
+extern _Thread_local int attrsetWords __attribute__((tls_model("initial-exec")));
+
+static inline int activeAttrsetWords(void)
+{
+  return attrsetWords;
+}
+
+/* Garante largura para attrCount atributos na thread; -1 se excede
+   ATTRSET_MAX_ATTRS */
+int attrsetReserve(int attrCount);
+
+/* Instala a largura de um esquema na thread (1 antes de carregar um
+   esquema novo: a carga alarga só o necessário) */
+void attrsetUseWords(int words);
+
+/* Executa STMT para cada palavra ativa, com caminho dedicado por largura */
+#if ATTRSET_MAX_WORDS >= 4
+#define ATTRSET_EACH_WORD(i, STMT)                \
+  {                                               \
+    const int activeWords = activeAttrsetWords(); \
+    switch (activeWords)                          \
+    {                                             \
+    case 1:                                       \
+    {                                             \
+      const int i = 0;                            \
+      STMT;                                       \
+      break;                                      \
+    }                                             \
+    case 2:                                       \
+      for (int i = 0; i < 2; ++i)                 \
+        STMT;                                     \
+      break;                                      \
+    case 4:                                       \
+      for (int i = 0; i < 4; ++i)                 \
+        STMT;                                     \
+      break;                                      \
+    default:                                      \
+      for (int i = 0; i < activeWords; ++i)       \
+        STMT;                                     \
+      break;                                      \
+    }                                             \
+  }
+#else
+#define ATTRSET_EACH_WORD(i, STMT)                \
+  {                                               \
+    const int activeWords = activeAttrsetWords(); \
+    switch (activeWords)                          \
+    {                                             \
+    case 1:                                       \
+    {                                             \
+      const int i = 0;                            \
+      STMT;                                       \
+      break;                                      \
+    }                                             \
+    default:                                      \
+      for (int i = 0; i < activeWords; ++i)       \
+        STMT;                                     \
+      break;                                      \
+    }                                             \
+  }
+#endif
+
+static inline attrset attrsetEmpty(void)
+{
+  attrset s = {{0}};
+  return s;
+}
+
+static inline int attrsetHas(attrset s, int a)
+{
+  return (int)((s.w[a >> 6] >> (a & 63)) & 1u);
+}
+
+static inline void attrsetInsert(attrset *s, int a)
+{
+  s->w[a >> 6] |= (uint64_t)1 << (a & 63);
+}
+
+static inline void attrsetErase(attrset *s, int a)
+{
+  s->w[a >> 6] &= ~((uint64_t)1 << (a & 63));
+}
+
+static inline attrset attrsetSingleton(int a)
+{
+  attrset s = attrsetEmpty();
+  attrsetInsert(&s, a);
+  return s;
+}
+
+// s ∪ {a}
+static inline attrset attrsetWith(attrset s, int a)
+{
+  attrsetInsert(&s, a);
+  return s;
+}
+
+// s \ {a}
+static inline attrset attrsetWithout(attrset s, int a)
+{
+  attrsetErase(&s, a);
+  return s;
+}
+
+static inline attrset attrsetUnion(attrset a, attrset b)
+{
+  ATTRSET_EACH_WORD(i, a.w[i] |= b.w[i]);
+  return a;
+}
+
+static inline attrset attrsetIntersect(attrset a, attrset b)
+{
+  ATTRSET_EACH_WORD(i, a.w[i] &= b.w[i]);
+  return a;
+}
+
+// a \ b
+static inline attrset attrsetMinus(attrset a, attrset b)
+{
+  ATTRSET_EACH_WORD(i, a.w[i] &= ~b.w[i]);
+  return a;
+}
+
+// A ⊆ B
+static inline int attrsetIsSubset(attrset subset, attrset superset)
+{
+  uint64_t outside = 0;
+  ATTRSET_EACH_WORD(i, outside |= subset.w[i] & ~superset.w[i]);
+  return outside == 0;
+}
+
+static inline int attrsetIntersects(attrset a, attrset b)
+{
+  uint64_t common = 0;
+  ATTRSET_EACH_WORD(i, common |= a.w[i] & b.w[i]);
+  return common != 0;
+}
+
+static inline int attrsetEquals(attrset a, attrset b)
+{
+  uint64_t diff = 0;
+  ATTRSET_EACH_WORD(i, diff |= a.w[i] ^ b.w[i]);
+  return diff == 0;
+}
+
+static inline int attrsetIsEmpty(attrset s)
+{
+  uint64_t any = 0;
+  ATTRSET_EACH_WORD(i, any |= s.w[i]);
+  return any == 0;
+}
+
+static inline int attrsetCount(attrset s)
+{
+  int count = 0;
+  ATTRSET_EACH_WORD(i, count += __builtin_popcountll(s.w[i]));
+  return count;
+}
+
+/* Menor atributo de s com índice >= from, ou -1.
+   Iteração: for (a = attrsetNext(s, 0); a >= 0; a = attrsetNext(s, a + 1)) */
+static inline int attrsetNext(attrset s, int from)
+{
+  int words = activeAttrsetWords();
+  int w = from >> 6;
+  if (w >= words)
+    return -1;
+
+  uint64_t word = s.w[w] & (~(uint64_t)0 << (from & 63));
+  for (;;)
+  {
+    if (word)
+      return (w << 6) + __builtin_ctzll(word);
+    if (++w >= words)
+      return -1;
+    word = s.w[w];
+  }
+}
+
+/* Ordem canônica: por tamanho e, entre conjuntos do mesmo tamanho,
+   lexicográfica pelos índices (vence quem tem o menor atributo da
+   diferença simétrica). Retorna <0, 0 ou >0. */
+static inline int attrsetCompare(attrset a, attrset b)
+{
+  int countA = attrsetCount(a), countB = attrsetCount(b);
+  if (countA != countB)
+    return countA < countB ? -1 : 1;
+
+  for (int i = 0, words = activeAttrsetWords(); i < words; ++i)
+  {
+    uint64_t diff = a.w[i] ^ b.w[i];
+    if (diff)
+      return (a.w[i] & diff & -diff) ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Não depende da largura: palavras zero no fim não entram no hash (o
+   valor é o do prefixo até a última palavra não nula) */
+static inline uint64_t attrsetHash(attrset s)
+{
+  uint64_t h = 0x9e3779b97f4a7c15ull;
+  uint64_t last = h;
+  ATTRSET_EACH_WORD(i, {
+    h = (h ^ s.w[i]) * 0xff51afd7ed558ccdull;
+    last = s.w[i] ? h : last;
+  });
+  return last ^ (last >> 32);
+}
+
+#endif
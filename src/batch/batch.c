@@ -0,0 +1,649 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include "analysis.h"
+#include "arena.h"
+#include "catalog.h"
+#include "fdb.h"
+#include "normalform.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ---------------------------------------------------------------
+   Lista de entrada: um item por esquema. Catálogos são lidos (numa
+   passada) ao entrar na lista e viram um item por relação.
+---------------------------------------------------------------- */
+typedef struct
+{
+  char *path;
+  const Catalog *catalog; // NULL fora de catálogos
+  int relation;
+  int invalid; // catálogo que não pôde ser lido (erro já em stderr)
+} BatchInput;
+
+typedef struct
+{
+  BatchInput *inputs;
+  int count;
+  int capacity;
+
+  Catalog **catalogs;
+  int catalogCount;
+} InputList;
+
+static int pushInput(InputList *list, const char *path, const Catalog *catalog, int relation, int invalid)
+{
+  if (list->count == list->capacity)
+  {
+    int capacity = list->capacity ? list->capacity * 2 : 256;
+    BatchInput *grown = realloc(list->inputs, sizeof(BatchInput) * capacity);
+    if (!grown)
+      return -1;
+    list->inputs = grown;
+    list->capacity = capacity;
+  }
+
+  BatchInput *input = &list->inputs[list->count];
+  input->path = strdup(path);
+  if (!input->path)
+    return -1;
+  input->catalog = catalog;
+  input->relation = relation;
+  input->invalid = invalid;
+  list->count++;
+  return 0;
+}
+
+static int appendPath(InputList *list, const char *path)
+{
+  if (!isCatalogFile(path))
+    return pushInput(list, path, NULL, 0, 0);
+
+  Catalog **grown = realloc(list->catalogs, sizeof(Catalog *) * (list->catalogCount + 1));
+  Catalog *catalog = malloc(sizeof(Catalog));
+  if (grown)
+    list->catalogs = grown;
+  if (!grown || !catalog)
+  {
+    free(catalog);
+    return -1;
+  }
+
+  if (loadCatalog(path, NULL, catalog) != 0)
+  {
+    free(catalog);
+    return pushInput(list, path, NULL, 0, 1);
+  }
+
+  list->catalogs[list->catalogCount++] = catalog;
+  for (int r = 0; r < catalog->count; ++r)
+    if (pushInput(list, path, catalog, r, 0) != 0)
+      return -1;
+  return 0;
+}
+
+static void freeInputList(InputList *list)
+{
+  for (int i = 0; i < list->count; ++i)
+    free(list->inputs[i].path);
+  free(list->inputs);
+
+  for (int c = 0; c < list->catalogCount; ++c)
+  {
+    freeCatalog(list->catalogs[c]);
+    free(list->catalogs[c]);
+  }
+  free(list->catalogs);
+}
+
+static int hasSchemaExtension(const char *name)
+{
+  size_t length = strlen(name);
+  if (length <= 4)
+    return 0;
+
+  const char *extension = name + length - 4;
+  return strcmp(extension, ".fds") == 0 || strcmp(extension, ".fdb") == 0 || strcmp(extension, ".fdc") == 0;
+}
+
+static int compareNames(const void *a, const void *b)
+{
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int listDirectory(const char *dirPath, InputList *list)
+{
+  DIR *dir = opendir(dirPath);
+  if (!dir)
+  {
+    fprintf(stderr, "Error: cannot open directory %s\n", dirPath);
+    return -1;
+  }
+
+  size_t dirLength = strlen(dirPath);
+  int slash = dirLength > 0 && dirPath[dirLength - 1] == '/';
+  char **paths = NULL;
+  int count = 0, capacity = 0;
+  int status = 0;
+  struct dirent *entry;
+
+  while (status == 0 && (entry = readdir(dir)) != NULL)
+  {
+    if (entry->d_name[0] == '.' || !hasSchemaExtension(entry->d_name))
+      continue;
+
+    if (count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 256;
+      char **grown = realloc(paths, sizeof(char *) * capacity);
+      if (!grown)
+      {
+        status = -1;
+        break;
+      }
+      paths = grown;
+    }
+
+    paths[count] = malloc(dirLength + strlen(entry->d_name) + 2);
+    if (!paths[count])
+    {
+      status = -1;
+      break;
+    }
+    sprintf(paths[count++], "%s%s%s", dirPath, slash ? "" : "/", entry->d_name);
+  }
+  closedir(dir);
+
+  qsort(paths, count, sizeof(char *), compareNames);
+  for (int i = 0; i < count && status == 0; ++i)
+    status = appendPath(list, paths[i]);
+
+  for (int i = 0; i < count; ++i)
+    free(paths[i]);
+  free(paths);
+
+  if (status != 0)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+  return 0;
+}
+
+// Um caminho por linha; linhas vazias e comentários (#) são ignorados
+static int listFile(const char *listPath, InputList *list)
+{
+  FILE *in = strcmp(listPath, "-") == 0 ? stdin : fopen(listPath, "r");
+  if (!in)
+  {
+    fprintf(stderr, "Error: cannot open %s\n", listPath);
+    return -1;
+  }
+
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  int status = 0;
+
+  while (status == 0 && (length = getline(&line, &capacity, in)) >= 0)
+  {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' ||
+                          line[length - 1] == '\t'))
+      line[--length] = '\0';
+
+    char *path = line + strspn(line, " \t");
+    if (*path == '\0' || *path == '#')
+      continue;
+
+    if (appendPath(list, path) != 0)
+    {
+      fprintf(stderr, "Error: out of memory\n");
+      status = -1;
+    }
+  }
+
+  free(line);
+  if (in != stdin)
+    fclose(in);
+  return status;
+}
+
+/* ---------------------------------------------------------------
+   Janela entre os estágios: a posição seq % windowSize é do leitor
+   até readCount passar de seq, de um trabalhador até done, e do
+   escritor até writeNext passar de seq
+---------------------------------------------------------------- */
+typedef struct
+{
+  int loaded;
+  AttrDict dict;
+  FdSchema schema;
+  int attrWords; // largura de conjuntos que a carga deixou no leitor
+
+  int done;
+  char *line;
+  size_t lineLength;
+  int failed;
+} BatchSlot;
+
+typedef struct
+{
+  const InputList *list;
+  int analyses;
+
+  BatchSlot *slots;
+  int windowSize;
+
+  pthread_mutex_t lock;
+  pthread_cond_t readable; // readCount avançou
+  pthread_cond_t finished; // alguma posição ficou pronta
+  pthread_cond_t released; // writeNext avançou
+  int readCount;
+  int workNext;
+  int writeNext;
+  int cancelled; // sem trabalhadores: o leitor para
+} Batch;
+
+static void *readerMain(void *arg)
+{
+  Batch *batch = arg;
+
+  for (int seq = 0; seq < batch->list->count; ++seq)
+  {
+    pthread_mutex_lock(&batch->lock);
+    while (seq - batch->writeNext >= batch->windowSize && !batch->cancelled)
+      pthread_cond_wait(&batch->released, &batch->lock);
+    int cancelled = batch->cancelled;
+    pthread_mutex_unlock(&batch->lock);
+    if (cancelled)
+      break;
+
+    const BatchInput *input = &batch->list->inputs[seq];
+    BatchSlot *slot = &batch->slots[seq % batch->windowSize];
+    initAttrDict(&slot->dict);
+    attrsetUseWords(1);
+    if (input->catalog)
+      slot->loaded = catalogRelationSchema(input->catalog, input->relation, &slot->dict, &slot->schema) == 0;
+    else
+      slot->loaded = !input->invalid && loadSchema(input->path, &slot->dict, &slot->schema) == 0;
+    slot->attrWords = activeAttrsetWords();
+
+    pthread_mutex_lock(&batch->lock);
+    batch->readCount = seq + 1;
+    pthread_cond_signal(&batch->readable);
+    pthread_mutex_unlock(&batch->lock);
+  }
+
+  // Acorda os trabalhadores que esperam um arquivo que não vem
+  pthread_mutex_lock(&batch->lock);
+  pthread_cond_broadcast(&batch->readable);
+  pthread_mutex_unlock(&batch->lock);
+  return NULL;
+}
+
+/* ---------------------------------------------------------------
+   Linha JSON de um arquivo
+---------------------------------------------------------------- */
+static void writeJsonString(FILE *out, const char *s)
+{
+  putc('"', out);
+  for (; *s; ++s)
+  {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\')
+      fprintf(out, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(out, "\\u%04x", c);
+    else
+      putc(c, out);
+  }
+  putc('"', out);
+}
+
+static void writeJsonAttrset(FILE *out, const AttrDict *dict, attrset set)
+{
+  putc('[', out);
+  const char *separator = "";
+  for (int a = attrsetNext(set, 0); a >= 0; a = attrsetNext(set, a + 1))
+  {
+    fputs(separator, out);
+    writeJsonString(out, dict->names[a]);
+    separator = ", ";
+  }
+  putc(']', out);
+}
+
+static void writeJsonFd(FILE *out, const AttrDict *dict, const FD *fd)
+{
+  fputs("{\"lhs\": ", out);
+  writeJsonAttrset(out, dict, fd->lhs);
+  fputs(", \"rhs\": ", out);
+  writeJsonAttrset(out, dict, fd->rhs);
+  putc('}', out);
+}
+
+static void writeJsonNormalForm(FILE *out, const char *name, const AttrDict *dict, const FD *cover,
+                                int coverCount, const char *violates)
+{
+  int ok = 1;
+  for (int i = 0; i < coverCount && ok; ++i)
+    ok = !violates[i];
+
+  fprintf(out, ", \"%s\": {\"ok\": %s, \"violations\": [", name, ok ? "true" : "false");
+  const char *separator = "";
+  for (int i = 0; i < coverCount; ++i)
+  {
+    if (!violates[i])
+      continue;
+    fputs(separator, out);
+    writeJsonFd(out, dict, &cover[i]);
+    separator = ", ";
+  }
+  fputs("]}", out);
+}
+
+// Análises pedidas sobre o esquema da posição; 0 ou -1 sem memória
+static int writeJsonAnalyses(FILE *out, BatchSlot *slot, int analyses)
+{
+  const AttrDict *dict = &slot->dict;
+  FdSchema *schema = &slot->schema;
+
+  AnalysisContext ctx;
+  initAnalysisContext(&ctx, schema->U, schema->fds, schema->fdCount);
+  analysisUsePrecomputed(&ctx, schema->cover, schema->coverCount, schema->closureIndex, schema->keys,
+                         schema->keyCount);
+
+  fprintf(out, ", \"attributes\": %d, \"fds\": %d", dict->count, schema->fdCount);
+  int failed = 0;
+
+  int coverCount = 0;
+  const FD *cover = analysisCover(&ctx, &coverCount);
+
+  if (analyses & BATCH_MINCOVER)
+  {
+    fputs(", \"mincover\": [", out);
+    for (int i = 0; i < coverCount; ++i)
+    {
+      if (i > 0)
+        fputs(", ", out);
+      writeJsonFd(out, dict, &cover[i]);
+    }
+    putc(']', out);
+  }
+
+  if ((analyses & BATCH_KEYS) && !analysisFailed(&ctx))
+  {
+    int keyCount = 0;
+    const attrset *keys = analysisKeys(&ctx, &keyCount);
+
+    fputs(", \"keys\": [", out);
+    for (int i = 0; i < keyCount; ++i)
+    {
+      if (i > 0)
+        fputs(", ", out);
+      writeJsonAttrset(out, dict, keys[i]);
+    }
+    fputs("], \"prime\": ", out);
+    writeJsonAttrset(out, dict, analysisPrimeAttributes(&ctx));
+  }
+
+  if ((analyses & BATCH_NORMALFORM) && !analysisFailed(&ctx))
+  {
+    Arena *scratch = getScratchArena();
+    char *violatesBcnf = scratchCalloc(scratch, coverCount + 1, 1);
+    char *violates3nf = scratchCalloc(scratch, coverCount + 1, 1);
+
+    if (!violatesBcnf || !violates3nf || markNormalFormViolations(&ctx, violatesBcnf, violates3nf) != 0)
+      failed = 1;
+    else
+    {
+      writeJsonNormalForm(out, "bcnf", dict, cover, coverCount, violatesBcnf);
+      writeJsonNormalForm(out, "3nf", dict, cover, coverCount, violates3nf);
+    }
+
+    scratchFree(scratch, violatesBcnf);
+    scratchFree(scratch, violates3nf);
+  }
+
+  failed = failed || analysisFailed(&ctx);
+  freeAnalysisContext(&ctx);
+  return failed ? -1 : 0;
+}
+
+// Abre a linha: o arquivo e, num catálogo, a relação
+static void writeJsonSource(FILE *out, const BatchInput *input)
+{
+  fputs("{\"file\": ", out);
+  writeJsonString(out, input->path);
+  if (input->catalog)
+  {
+    fputs(", \"relation\": ", out);
+    writeJsonString(out, input->catalog->relations[input->relation].name);
+  }
+}
+
+static void writeJsonError(FILE *out, const BatchInput *input, const char *message)
+{
+  writeJsonSource(out, input);
+  fputs(", \"error\": ", out);
+  writeJsonString(out, message);
+  fputs("}\n", out);
+}
+
+static char *jsonErrorLine(const BatchInput *input, const char *message, size_t *outLength)
+{
+  char *line = NULL;
+  FILE *out = open_memstream(&line, outLength);
+  if (!out)
+    return NULL;
+
+  writeJsonError(out, input, message);
+  if (fclose(out) != 0)
+  {
+    free(line);
+    return NULL;
+  }
+  return line;
+}
+
+// Monta slot->line (NULL sem memória); o esquema é liberado em seguida
+static void analyzeSlot(BatchSlot *slot, const BatchInput *input, int analyses)
+{
+  const char *error = slot->loaded ? NULL : "cannot load schema";
+  slot->line = NULL;
+
+  if (slot->loaded)
+  {
+    int status = -1;
+    FILE *out = open_memstream(&slot->line, &slot->lineLength);
+    if (out)
+    {
+      writeJsonSource(out, input);
+      status = writeJsonAnalyses(out, slot, analyses);
+      fputs("}\n", out);
+      if (fclose(out) != 0)
+        status = -1;
+    }
+
+    if (status != 0)
+    {
+      free(slot->line);
+      slot->line = NULL;
+      error = "out of memory";
+    }
+    freeSchema(&slot->schema);
+  }
+  freeAttrDict(&slot->dict);
+
+  if (error)
+  {
+    slot->failed = 1;
+    slot->line = jsonErrorLine(input, error, &slot->lineLength);
+  }
+}
+
+static void *workerMain(void *arg)
+{
+  Batch *batch = arg;
+
+  Arena scratch;
+  initArena(&scratch, 0);
+  Arena *previous = setScratchArena(&scratch);
+
+  for (;;)
+  {
+    pthread_mutex_lock(&batch->lock);
+    while (batch->workNext >= batch->readCount && batch->readCount < batch->list->count)
+      pthread_cond_wait(&batch->readable, &batch->lock);
+    if (batch->workNext >= batch->list->count)
+    {
+      pthread_mutex_unlock(&batch->lock);
+      break;
+    }
+    int seq = batch->workNext++;
+    pthread_mutex_unlock(&batch->lock);
+
+    BatchSlot *slot = &batch->slots[seq % batch->windowSize];
+    attrsetUseWords(slot->attrWords);
+    analyzeSlot(slot, &batch->list->inputs[seq], batch->analyses);
+    arenaReset(&scratch);
+
+    pthread_mutex_lock(&batch->lock);
+    slot->done = 1;
+    pthread_cond_broadcast(&batch->finished);
+    pthread_mutex_unlock(&batch->lock);
+  }
+
+  setScratchArena(previous);
+  freeArena(&scratch);
+  return NULL;
+}
+
+/* ---------------------------------------------------------------
+   Escritor: a thread chamadora
+---------------------------------------------------------------- */
+static int writeResults(Batch *batch, FILE *out)
+{
+  int failures = 0;
+
+  for (int seq = 0; seq < batch->list->count; ++seq)
+  {
+    BatchSlot *slot = &batch->slots[seq % batch->windowSize];
+
+    pthread_mutex_lock(&batch->lock);
+    while (!slot->done)
+      pthread_cond_wait(&batch->finished, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+
+    if (slot->line)
+      fwrite(slot->line, 1, slot->lineLength, out);
+    else
+      fprintf(stderr, "Error: out of memory writing the result of %s\n", batch->list->inputs[seq].path);
+    failures += slot->failed;
+
+    free(slot->line);
+    memset(slot, 0, sizeof(BatchSlot));
+
+    pthread_mutex_lock(&batch->lock);
+    batch->writeNext = seq + 1;
+    pthread_cond_signal(&batch->released);
+    pthread_mutex_unlock(&batch->lock);
+  }
+
+  fflush(out);
+  return failures;
+}
+
+int runBatch(const char *input, int jobs, int analyses, FILE *out)
+{
+  if (jobs <= 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    jobs = online > 0 ? (int)online : 1;
+  }
+
+  InputList list = {0};
+  struct stat info;
+  int listed;
+  if (stat(input, &info) == 0 && S_ISDIR(info.st_mode))
+    listed = listDirectory(input, &list);
+  else if (isCatalogFile(input))
+    listed = appendPath(&list, input);
+  else
+    listed = listFile(input, &list);
+
+  if (listed != 0)
+  {
+    freeInputList(&list);
+    return -1;
+  }
+
+  Batch batch = {0};
+  batch.list = &list;
+  batch.analyses = analyses;
+  batch.windowSize = jobs * BATCH_WINDOW_PER_JOB;
+  batch.slots = calloc(batch.windowSize, sizeof(BatchSlot));
+  pthread_t *workers = malloc(sizeof(pthread_t) * jobs);
+  if (!batch.slots || !workers)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    free(batch.slots);
+    free(workers);
+    freeInputList(&list);
+    return -1;
+  }
+
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.readable, NULL);
+  pthread_cond_init(&batch.finished, NULL);
+  pthread_cond_init(&batch.released, NULL);
+
+  pthread_t reader;
+  int started = 0;
+  int readerStarted = pthread_create(&reader, NULL, readerMain, &batch) == 0;
+  while (readerStarted && started < jobs && pthread_create(&workers[started], NULL, workerMain, &batch) == 0)
+    started++;
+
+  int status = -1;
+  if (!readerStarted || started == 0)
+  {
+    fprintf(stderr, "Error: cannot start batch threads\n");
+
+    // Ninguém consome o que o leitor já carregou
+    if (readerStarted)
+    {
+      pthread_mutex_lock(&batch.lock);
+      batch.cancelled = 1;
+      pthread_cond_broadcast(&batch.released);
+      pthread_mutex_unlock(&batch.lock);
+      pthread_join(reader, NULL);
+
+      for (int i = 0; i < batch.readCount && i < batch.windowSize; ++i)
+      {
+        if (batch.slots[i].loaded)
+          freeSchema(&batch.slots[i].schema);
+        freeAttrDict(&batch.slots[i].dict);
+      }
+    }
+  }
+  else
+  {
+    status = writeResults(&batch, out) > 0 ? 1 : 0;
+    pthread_join(reader, NULL);
+    for (int t = 0; t < started; ++t)
+      pthread_join(workers[t], NULL);
+  }
+
+  pthread_cond_destroy(&batch.released);
+  pthread_cond_destroy(&batch.finished);
+  pthread_cond_destroy(&batch.readable);
+  pthread_mutex_destroy(&batch.lock);
+  free(workers);
+  free(batch.slots);
+  freeInputList(&list);
+  return status;
+}
@@ -0,0 +1,51 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+/* -----------------------------------------------------------------------------
+   Processamento em lote (fdtool batch): muitos esquemas num só processo,
+   com a leitura sobreposta às análises.
+
+   Três estágios ligados por uma janela circular de BATCH_WINDOW_PER_JOB
+   arquivos por thread de trabalho:
+     - leitor (uma thread): lê e faz o parse dos arquivos na ordem da
+       entrada, adiantado até o tamanho da janela;
+     - trabalhadores (jobs threads): pegam o próximo esquema lido, rodam as
+       análises pedidas e montam a linha JSON do resultado. Cada um tem a
+       sua arena de rascunho, descartada a cada arquivo;
+     - escritor (a thread chamadora): escreve as linhas na ordem da
+       entrada, assim que a próxima fica pronta, e libera a posição da
+       janela para o leitor.
+   A memória fica limitada pela janela, não pelo número de arquivos.
+
+   Uma linha por esquema:
+       {"file": ..., "attributes": N, "fds": N,
+        "mincover": [{"lhs": [...], "rhs": [...]}, ...],
+        "keys": [[...], ...], "prime": [...],
+        "bcnf": {"ok": bool, "violations": [{"lhs": ..., "rhs": ...}]},
+        "3nf": {...}}
+   com só as análises pedidas; um arquivo que não carrega vira
+   {"file": ..., "error": "..."} (a mensagem do parser vai para stderr) e
+   não interrompe o lote. Um catálogo (.fdc) é lido uma vez, ao montar a
+   lista, e dá uma linha por relação, com "relation": ... logo depois de
+   "file".
+ ----------------------------------------------------------------------------- */
+#define BATCH_WINDOW_PER_JOB 4
+
+typedef enum
+{
+  BATCH_MINCOVER = 1 << 0,
+  BATCH_KEYS = 1 << 1, // chaves e atributos primos
+  BATCH_NORMALFORM = 1 << 2,
+  BATCH_ALL = BATCH_MINCOVER | BATCH_KEYS | BATCH_NORMALFORM
+} BatchAnalysis;
+
+/* Analisa os esquemas de input: um diretório (os arquivos .fds, .fdb e
+   .fdc dele, em ordem de nome), um catálogo ou uma lista com um caminho
+   por linha ("-" = stdin). analyses é uma combinação de BatchAnalysis. 0 se todos os
+   arquivos foram analisados, 1 se algum falhou, -1 se o lote nem começou
+   (erro em stderr). */
+int runBatch(const char *input, int jobs, int analyses, FILE *out);
+
+#endif
@@ -0,0 +1,135 @@
+#include "catalog.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Só o começo do arquivo é olhado para reconhecer um catálogo */
+#define CATALOG_SNIFF_SIZE 4096
+
+int isCatalogFile(const char *path)
+{
+  int fd = path ? open(path, O_RDONLY) : -1;
+  if (fd < 0)
+    return 0;
+
+  struct stat info;
+  char head[CATALOG_SNIFF_SIZE];
+  ssize_t got = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) ? read(fd, head, sizeof(head)) : -1;
+  close(fd);
+
+  ssize_t pos = 0;
+  while (pos < got && isspace((unsigned char)head[pos]))
+    pos++;
+
+  return got - pos > 8 && memcmp(head + pos, "relation", 8) == 0 && isspace((unsigned char)head[pos + 8]);
+}
+
+/* Recebe cada bloco do parser, com os nomes já no dicionário do
+   catálogo, e guarda a relação em índices locais */
+static int addRelation(void *context, const char *name, size_t nameLength, int *attributes, int attributeCount,
+                       attrset U, FD *fds, int fdCount)
+{
+  Catalog *catalog = context;
+
+  int index = internName(&catalog->relationNames, name, nameLength);
+  if (index >= 0 && index < catalog->count)
+  {
+    fprintf(stderr, "Error: duplicate relation %.*s\n", (int)nameLength, name);
+    free(attributes);
+    free(fds);
+    return -1;
+  }
+
+  if (index >= 0 && catalog->count == catalog->capacity)
+  {
+    int capacity = catalog->capacity ? catalog->capacity * 2 : 16;
+    CatalogRelation *grown = realloc(catalog->relations, sizeof(CatalogRelation) * capacity);
+    if (grown)
+    {
+      catalog->relations = grown;
+      catalog->capacity = capacity;
+    }
+  }
+
+  if (index < 0 || catalog->count == catalog->capacity)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    free(attributes);
+    free(fds);
+    return -1;
+  }
+
+  CatalogRelation *relation = &catalog->relations[catalog->count++];
+  relation->name = catalog->relationNames.names[index];
+  relation->attributes = attributes;
+  relation->attributeCount = attributeCount;
+  relation->U = U;
+  relation->fds = fds;
+  relation->fdCount = fdCount;
+  return 0;
+}
+
+int loadCatalog(const char *path, const char *only, Catalog *catalog)
+{
+  memset(catalog, 0, sizeof(Catalog));
+  initAttrDict(&catalog->names);
+  initAttrDict(&catalog->relationNames);
+
+  if (parseFdsCatalogFile(path, only, &catalog->names, addRelation, catalog) != 0)
+  {
+    freeCatalog(catalog);
+    return -1;
+  }
+  return 0;
+}
+
+void freeCatalog(Catalog *catalog)
+{
+  for (int r = 0; r < catalog->count; ++r)
+  {
+    free(catalog->relations[r].attributes);
+    free(catalog->relations[r].fds);
+  }
+  free(catalog->relations);
+  freeAttrDict(&catalog->relationNames);
+  freeAttrDict(&catalog->names);
+  memset(catalog, 0, sizeof(Catalog));
+}
+
+int findCatalogRelation(const Catalog *catalog, const char *name)
+{
+  int index = findAttribute(&catalog->relationNames, name, strlen(name));
+  return index < catalog->count ? index : -1;
+}
+
+int catalogRelationSchema(const Catalog *catalog, int relation, AttrDict *dict, FdSchema *schema)
+{
+  const CatalogRelation *source = &catalog->relations[relation];
+  memset(schema, 0, sizeof(FdSchema));
+
+  /* Mesmos nomes na mesma ordem: os índices locais continuam valendo */
+  for (int a = 0; a < source->attributeCount; ++a)
+  {
+    const char *name = catalog->names.names[source->attributes[a]];
+    if (internAttribute(dict, name, strlen(name)) != a)
+    {
+      fprintf(stderr, "Error: cannot rebuild the attributes of relation %s\n", source->name);
+      return -1;
+    }
+  }
+
+  schema->fds = malloc(sizeof(FD) * (source->fdCount > 0 ? source->fdCount : 1));
+  if (!schema->fds)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+  memcpy(schema->fds, source->fds, sizeof(FD) * source->fdCount);
+  schema->fdCount = source->fdCount;
+  schema->U = source->U;
+  return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "parser.h"
+#include "fdb.h"
+
+/* -----------------------------------------------------------------------------
+   Catálogo de esquemas: muitas relações num arquivo só, sobre um
+   dicionário de atributos compartilhado.
+
+       relation empregado {
+         U={emp_id, nome, depto}
+         F={emp_id -> nome depto}
+       }
+       relation departamento {
+         U={depto, chefe}
+         F={depto -> chefe}
+       }
+
+   O arquivo é lido numa passada. Cada nome de atributo é internado uma
+   vez no dicionário do catálogo (sem limite de atributos: os índices dele
+   não entram em attrsets); cada relação guarda a lista dos seus atributos
+   e as suas DFs em índices locais, na ordem em que aparecem no bloco.
+   Assim cada relação tem a própria capacidade de ATTRSET_MAX_ATTRS e é
+   analisada exatamente como o mesmo bloco num .fds isolado, sem passar
+   pelas outras.
+
+   Carregando uma relação só (only), os blocos anteriores são pulados sem
+   parse e a leitura para no bloco pedido.
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  const char *name;  // no dicionário de nomes de relação do catálogo
+  int *attributes;   // índice no dicionário do catálogo de cada atributo local
+  int attributeCount;
+  attrset U;         // índices locais
+  FD *fds;           // índices locais
+  int fdCount;
+} CatalogRelation;
+
+typedef struct
+{
+  AttrDict names;         // atributos de todas as relações
+  AttrDict relationNames; // nome -> índice em relations
+
+  CatalogRelation *relations;
+  int count;
+  int capacity;
+} Catalog;
+
+// 1 se path é um arquivo regular que começa com um bloco "relation"
+int isCatalogFile(const char *path);
+
+/* Lê o catálogo (com only != NULL, só essa relação). 0 ou -1 com erro em
+   stderr; nomes de relação repetidos são erro. */
+int loadCatalog(const char *path, const char *only, Catalog *catalog);
+void freeCatalog(Catalog *catalog);
+
+// Índice da relação, ou -1 se não existe
+int findCatalogRelation(const Catalog *catalog, const char *name);
+
+/* Esquema da relação, como se lido de um .fds só com ela: dict (vazio)
+   recebe os atributos na ordem local e schema uma cópia das DFs.
+   0 ou -1 com erro em stderr. */
+int catalogRelationSchema(const Catalog *catalog, int relation, AttrDict *dict, FdSchema *schema);
+
+#endif
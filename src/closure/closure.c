@@ -1,32 +1,1001 @@
 #include "closure.h"
+#include "stats.h"
+#include "arena.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ClosureEngine currentEngine = CLOSURE_ENGINE_LINEAR;
+
+void setClosureEngine(ClosureEngine engine)
+{
+  currentEngine = engine;
+}
+
+ClosureEngine getClosureEngine(void)
+{
+  return currentEngine;
+}
 
 // Retorna o fecho X+ de X sob F
 attrset computeClosure(attrset X, FD *fds, int nfds)
 {
   attrset closure = X;
   int changed = 1;
+  int passes = 0;
 
   while (changed)
   {
     changed = 0;
+    passes++;
 
     for (int i = 0; i < nfds; ++i)
     {
       // Se LHS está contido no fecho
-      if ((closure & fds[i].lhs) == fds[i].lhs)
+      if (attrsetIsSubset(fds[i].lhs, closure))
       {
         // atributos de RHS que ainda não foram incluídos no fecho
-        attrset missing = fds[i].rhs & (~closure);
+        attrset missing = attrsetMinus(fds[i].rhs, closure);
+
+        if (!attrsetIsEmpty(missing))
+        {
+          closure = attrsetUnion(closure, missing);
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  STATS_COUNT(STAT_CLOSURES, 1);
+  STATS_COUNT(STAT_FIXPOINT_ITERATIONS, passes);
+  return closure;
+}
+
+/* -----------------------------------------------------------------------------
+   Construção do índice: para cada atributo, a lista das FDs que o têm no LHS.
+   Custo O(|F|) por conjunto de FDs.
+ ----------------------------------------------------------------------------- */
+/* Versões nunca se repetem no processo, nem entre índices */
+static uint64_t lastIndexVersion = 0;
+
+static uint64_t newIndexVersion(void)
+{
+  return __atomic_add_fetch(&lastIndexVersion, 1, __ATOMIC_RELAXED);
+}
+
+/* Pós-ordem reversa de uma busca em profundidade no grafo A -> B das FDs
+   de LHS unitário, as que disparam sempre que A está presente: numa cadeia,
+   cada atributo sai da fila do lote só depois dos que lhe dão bits, e é
+   propagado uma vez. FDs de LHS composto ficam de fora, porque só disparam
+   em parte das consultas e, com elas, o grafo vira um ciclo só (a ordem é
+   só heurística: qualquer ordem dá o mesmo fecho). Atributos sem arestas
+   ficam em ordem crescente. */
+static int buildPropagationOrder(ClosureIndex *index)
+{
+  int n = index->attrCount;
+  index->attrRank = malloc(sizeof(int) * (n > 0 ? n : 1));
+  index->rankAttr = malloc(sizeof(int) * (n > 0 ? n : 1));
+
+  Arena *scratch = getScratchArena();
+  int *stack = scratchAlloc(scratch, sizeof(int) * 3 * (n > 0 ? n : 1));
+  if (!index->attrRank || !index->rankAttr || !stack)
+  {
+    scratchFree(scratch, stack);
+    return -1;
+  }
+
+  /* Por nível da pilha: atributo, posição na sua lista de FDs e no RHS
+     da FD atual (-1 = ainda não começou) */
+  int *listPos = stack + n;
+  int *rhsPos = stack + 2 * n;
+  const int unvisited = -1, open = -2;
+  int next = n;
+
+  for (int a = 0; a < n; ++a)
+    index->attrRank[a] = unvisited;
+
+  for (int root = n - 1; root >= 0; --root)
+  {
+    if (index->attrRank[root] != unvisited)
+      continue;
+
+    int top = 0;
+    index->attrRank[root] = open;
+    stack[top] = root;
+    listPos[top] = index->listStart[root];
+    rhsPos[top++] = -1;
+
+    while (top > 0)
+    {
+      int b = stack[top - 1];
+      int child = -1;
+
+      while (child < 0 && listPos[top - 1] < index->listStart[b + 1])
+      {
+        int i = index->listFds[listPos[top - 1]];
+        if (index->lhsSize[i] != 1)
+        {
+          listPos[top - 1]++;
+          continue;
+        }
+
+        if (rhsPos[top - 1] < 0)
+          rhsPos[top - 1] = index->fdRhsStart[i];
+
+        if (rhsPos[top - 1] < index->fdRhsStart[i + 1])
+        {
+          int c = index->fdRhsAttrs[rhsPos[top - 1]++];
+          if (c < n && index->attrRank[c] == unvisited)
+            child = c;
+        }
+        else
+        {
+          listPos[top - 1]++;
+          rhsPos[top - 1] = -1;
+        }
+      }
+
+      if (child >= 0)
+      {
+        index->attrRank[child] = open;
+        stack[top] = child;
+        listPos[top] = index->listStart[child];
+        rhsPos[top++] = -1;
+      }
+      else
+      {
+        top--;
+        index->attrRank[b] = --next;
+        index->rankAttr[next] = b;
+      }
+    }
+  }
+
+  scratchFree(scratch, stack);
+  return 0;
+}
+
+ClosureIndex *buildClosureIndex(const FD *fds, int fdCount)
+{
+  ClosureIndex *index = calloc(1, sizeof(ClosureIndex));
+  if (!index)
+    return NULL;
+
+  int n = fdCount > 0 ? fdCount : 1;
+  index->fdCount = fdCount;
+  index->version = newIndexVersion();
+  index->lhs = malloc(sizeof(attrset) * n);
+  index->rhs = malloc(sizeof(attrset) * n);
+  index->lhsSize = malloc(sizeof(int) * n);
+  index->enabled = malloc(n);
+  index->emptyLhsFds = malloc(sizeof(int) * n);
+
+  if (!index->lhs || !index->rhs || !index->lhsSize || !index->enabled ||
+      !index->emptyLhsFds || initClosureScratch(&index->scratch, index) != 0)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+
+  /* Copia as FDs e descobre o maior atributo usado em algum LHS */
+  attrset allLhsAttributes = attrsetEmpty();
+  int totalEntries = 0;
+
+  for (int i = 0; i < fdCount; ++i)
+  {
+    index->lhs[i] = fds[i].lhs;
+    index->rhs[i] = fds[i].rhs;
+    index->lhsSize[i] = attrsetCount(fds[i].lhs);
+    index->enabled[i] = 1;
+
+    if (index->lhsSize[i] == 0)
+      index->emptyLhsFds[index->emptyLhsCount++] = i;
+
+    allLhsAttributes = attrsetUnion(allLhsAttributes, fds[i].lhs);
+    totalEntries += index->lhsSize[i];
+  }
+
+  int attrCount = 0;
+  for (int b = attrsetNext(allLhsAttributes, 0); b >= 0; b = attrsetNext(allLhsAttributes, b + 1))
+    attrCount = b + 1;
+
+  index->attrCount = attrCount;
+  index->listStart = calloc(attrCount + 1, sizeof(int));
+  index->listEnd = malloc(sizeof(int) * (attrCount > 0 ? attrCount : 1));
+  index->listFds = malloc(sizeof(int) * (totalEntries > 0 ? totalEntries : 1));
+  if (!index->listStart || !index->listEnd || !index->listFds)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+
+  /* Conta ocorrências de cada atributo nos LHS */
+  for (int i = 0; i < fdCount; ++i)
+    for (int b = attrsetNext(fds[i].lhs, 0); b >= 0; b = attrsetNext(fds[i].lhs, b + 1))
+      index->listStart[b + 1]++;
+
+  for (int b = 0; b < attrCount; ++b)
+    index->listStart[b + 1] += index->listStart[b];
+
+  /* Preenche as listas atributo -> FDs */
+  Arena *scratch = getScratchArena();
+  int *fill = scratchAlloc(scratch, sizeof(int) * (attrCount > 0 ? attrCount : 1));
+  if (!fill)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+  memcpy(fill, index->listStart, sizeof(int) * attrCount);
+  memcpy(index->listEnd, index->listStart + 1, sizeof(int) * attrCount);
+
+  for (int i = 0; i < fdCount; ++i)
+    for (int b = attrsetNext(fds[i].lhs, 0); b >= 0; b = attrsetNext(fds[i].lhs, b + 1))
+      index->listFds[fill[b]++] = i;
+
+  scratchFree(scratch, fill);
+
+  /* Listas de atributos de cada FD */
+  int totalRhs = 0;
+  attrset allAttributes = allLhsAttributes;
+  for (int i = 0; i < fdCount; ++i)
+  {
+    totalRhs += attrsetCount(fds[i].rhs);
+    allAttributes = attrsetUnion(allAttributes, fds[i].rhs);
+  }
+
+  for (int b = attrsetNext(allAttributes, 0); b >= 0; b = attrsetNext(allAttributes, b + 1))
+    index->fdAttrCount = b + 1;
+
+  index->fdLhsStart = malloc(sizeof(int) * (n + 1));
+  index->fdRhsStart = malloc(sizeof(int) * (n + 1));
+  index->fdLhsAttrs = malloc(sizeof(int) * (totalEntries > 0 ? totalEntries : 1));
+  index->fdRhsAttrs = malloc(sizeof(int) * (totalRhs > 0 ? totalRhs : 1));
+  if (!index->fdLhsStart || !index->fdRhsStart || !index->fdLhsAttrs || !index->fdRhsAttrs)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+
+  int lhsFill = 0, rhsFill = 0;
+  for (int i = 0; i < fdCount; ++i)
+  {
+    index->fdLhsStart[i] = lhsFill;
+    index->fdRhsStart[i] = rhsFill;
+    for (int b = attrsetNext(fds[i].lhs, 0); b >= 0; b = attrsetNext(fds[i].lhs, b + 1))
+      index->fdLhsAttrs[lhsFill++] = b;
+    for (int b = attrsetNext(fds[i].rhs, 0); b >= 0; b = attrsetNext(fds[i].rhs, b + 1))
+      index->fdRhsAttrs[rhsFill++] = b;
+  }
+  index->fdLhsStart[fdCount] = lhsFill;
+  index->fdRhsStart[fdCount] = rhsFill;
+
+  if (buildPropagationOrder(index) != 0)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+  return index;
+}
+
+ClosureIndex *buildMergedClosureIndex(const FD *fds, int fdCount)
+{
+  FdTable *table = buildFdTable(fds, fdCount);
+  if (!table)
+    return NULL;
+
+  FD *merged = fdTableToFds(table);
+  ClosureIndex *index = merged ? buildClosureIndex(merged, table->count) : NULL;
+  free(merged);
 
-        if (missing != 0)
+  if (!index)
+  {
+    freeFdTable(table);
+    return NULL;
+  }
+
+  index->table = table;
+  return index;
+}
+
+ClosureIndex *wrapClosureIndex(const ClosureIndex *shape)
+{
+  ClosureIndex *index = malloc(sizeof(ClosureIndex));
+  if (!index)
+    return NULL;
+
+  *index = *shape;
+  index->borrowed = 1;
+  index->table = NULL;
+  index->disabledCount = 0;
+  index->version = newIndexVersion();
+
+  int n = index->fdCount > 0 ? index->fdCount : 1;
+  index->enabled = malloc(n);
+  index->listEnd = malloc(sizeof(int) * (index->attrCount > 0 ? index->attrCount : 1));
+  index->scratch.counter = NULL;
+  index->scratch.stamp = NULL;
+  index->attrRank = NULL;
+  index->rankAttr = NULL;
+
+  if (!index->enabled || !index->listEnd || initClosureScratch(&index->scratch, index) != 0 ||
+      buildPropagationOrder(index) != 0)
+  {
+    freeClosureIndex(index);
+    return NULL;
+  }
+
+  memset(index->enabled, 1, n);
+  memcpy(index->listEnd, index->listStart + 1, sizeof(int) * index->attrCount);
+  return index;
+}
+
+void freeClosureIndex(ClosureIndex *index)
+{
+  if (!index)
+    return;
+
+  free(index->enabled);
+  free(index->listEnd);
+  free(index->attrRank);
+  free(index->rankAttr);
+  freeClosureScratch(&index->scratch);
+
+  if (index->borrowed)
+  {
+    free(index);
+    return;
+  }
+
+  free(index->lhs);
+  free(index->rhs);
+  free(index->lhsSize);
+  free(index->listStart);
+  free(index->listFds);
+  free(index->emptyLhsFds);
+  free(index->fdLhsStart);
+  free(index->fdLhsAttrs);
+  free(index->fdRhsStart);
+  free(index->fdRhsAttrs);
+  freeFdTable(index->table);
+  free(index);
+}
+
+int initClosureScratch(ClosureScratch *scratch, const ClosureIndex *index)
+{
+  int n = index->fdCount > 0 ? index->fdCount : 1;
+  scratch->counter = malloc(sizeof(int) * n);
+  scratch->stamp = calloc(n, sizeof(unsigned));
+  scratch->epoch = 0;
+  scratch->size = n;
+
+  if (!scratch->counter || !scratch->stamp)
+  {
+    freeClosureScratch(scratch);
+    return -1;
+  }
+  return 0;
+}
+
+void freeClosureScratch(ClosureScratch *scratch)
+{
+  free(scratch->counter);
+  free(scratch->stamp);
+  scratch->counter = NULL;
+  scratch->stamp = NULL;
+}
+
+void setClosureIndexFd(ClosureIndex *index, int i, int enabled)
+{
+  enabled = enabled ? 1 : 0;
+  if (index->enabled[i] != enabled)
+  {
+    index->disabledCount += enabled ? -1 : 1;
+    index->version = newIndexVersion();
+  }
+  index->enabled[i] = (char)enabled;
+}
+
+void removeClosureIndexFd(ClosureIndex *index, int i)
+{
+  setClosureIndexFd(index, i, 0);
+
+  /* Tira a FD das listas dos atributos do seu LHS (troca com a última) */
+  for (int b = attrsetNext(index->lhs[i], 0); b >= 0; b = attrsetNext(index->lhs[i], b + 1))
+  {
+    for (int k = index->listStart[b]; k < index->listEnd[b]; ++k)
+    {
+      if (index->listFds[k] == i)
+      {
+        index->listFds[k] = index->listFds[--index->listEnd[b]];
+        break;
+      }
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+   Modo de referência: o laço original, aplicado às FDs ativas do índice,
+   menos skipFd
+ ----------------------------------------------------------------------------- */
+static attrset closureNaive(const ClosureIndex *index, attrset X, int skipFd)
+{
+  STATS_COUNT(STAT_CLOSURES, 1);
+
+  attrset closure = X;
+  int changed = 1;
+  int passes = 0;
+
+  while (changed)
+  {
+    changed = 0;
+    passes++;
+
+    for (int i = 0; i < index->fdCount; ++i)
+    {
+      if (!index->enabled[i] || i == skipFd)
+        continue;
+
+      if (attrsetIsSubset(index->lhs[i], closure))
+      {
+        attrset missing = attrsetMinus(index->rhs[i], closure);
+        if (!attrsetIsEmpty(missing))
         {
-          closure |= missing;
+          closure = attrsetUnion(closure, missing);
           changed = 1;
         }
       }
     }
   }
 
+  STATS_COUNT(STAT_FIXPOINT_ITERATIONS, passes);
+  return closure;
+}
+
+/* Motores iterativos, um fecho por vez. A tabela só tem as FDs todas:
+   com alguma desativada (ou skipFd), fica o laço original. */
+static attrset closureIterative(const ClosureIndex *index, attrset X, int skipFd)
+{
+  if (currentEngine == CLOSURE_ENGINE_TABLE && index->table && index->disabledCount == 0 && skipFd < 0)
+  {
+    STATS_COUNT(STAT_CLOSURES, 1);
+    return fdTableClosure(index->table, X);
+  }
+  return closureNaive(index, X, skipFd);
+}
+
+/* -----------------------------------------------------------------------------
+   LINCLOSURE: cada FD guarda quantos atributos do LHS ainda faltam no fecho.
+   Cada atributo novo decrementa os contadores das FDs da sua lista; quando um
+   contador zera, a FD dispara. Cada entrada do índice é visitada no máximo
+   uma vez, logo o custo é linear no tamanho de F.
+
+   Os contadores são reinicializados preguiçosamente (stamp/epoch), de modo
+   que uma consulta só toca as FDs alcançadas pelos atributos do fecho.
+ ----------------------------------------------------------------------------- */
+attrset computeClosureIndexed(ClosureIndex *index, attrset X)
+{
+  return computeClosureWithScratch(index, &index->scratch, X);
+}
+
+/* Núcleo do LINCLOSURE. Com goal, para assim que goal ⊆ fecho e retorna 1
+   (o fecho devolvido pode estar incompleto); sem goal, calcula o fecho todo.
+   A FD skipFd (-1 = nenhuma) é tratada como desativada. */
+static int linearClosure(const ClosureIndex *index, ClosureScratch *scratch, attrset X,
+                         const attrset *goal, int skipFd, attrset *out)
+{
+  if (++scratch->epoch == 0)
+  {
+    memset(scratch->stamp, 0, sizeof(unsigned) * scratch->size);
+    scratch->epoch = 1;
+  }
+  unsigned epoch = scratch->epoch;
+  int *counter = scratch->counter;
+  unsigned *stamp = scratch->stamp;
+
+  STATS_COUNT(STAT_CLOSURES, 1);
+  attrset closure = X;
+
+  for (int k = 0; k < index->emptyLhsCount; ++k)
+  {
+    int i = index->emptyLhsFds[k];
+    if (index->enabled[i] && i != skipFd)
+      closure = attrsetUnion(closure, index->rhs[i]);
+  }
+
+  int goalMissing = goal ? attrsetCount(attrsetMinus(*goal, closure)) : -1;
+  if (goalMissing == 0)
+  {
+    *out = closure;
+    return 1;
+  }
+
+  /* Fila dos atributos do fecho cujas listas ainda não foram processadas;
+     cada atributo entra uma única vez */
+  int queue[ATTRSET_MAX_ATTRS];
+  int head = 0, tail = 0;
+  for (int b = attrsetNext(closure, 0); b >= 0; b = attrsetNext(closure, b + 1))
+    queue[tail++] = b;
+
+  while (head < tail)
+  {
+    int b = queue[head++];
+    if (b >= index->attrCount)
+      continue;
+
+    for (int k = index->listStart[b]; k < index->listEnd[b]; ++k)
+    {
+      int i = index->listFds[k];
+      if (!index->enabled[i] || i == skipFd)
+        continue;
+
+      if (stamp[i] != epoch)
+      {
+        stamp[i] = epoch;
+        counter[i] = index->lhsSize[i];
+      }
+
+      if (--counter[i] != 0)
+        continue;
+
+      STATS_COUNT(STAT_FDS_FIRED, 1);
+      for (int r = index->fdRhsStart[i]; r < index->fdRhsStart[i + 1]; ++r)
+      {
+        int a = index->fdRhsAttrs[r];
+        if (attrsetHas(closure, a))
+          continue;
+
+        attrsetInsert(&closure, a);
+        queue[tail++] = a;
+
+        if (goal && attrsetHas(*goal, a) && --goalMissing == 0)
+        {
+          *out = closure;
+          return 1;
+        }
+      }
+    }
+  }
+
+  *out = closure;
+  return goal ? 0 : 1;
+}
+
+attrset computeClosureWithScratch(const ClosureIndex *index, ClosureScratch *scratch, attrset X)
+{
+  if (currentEngine != CLOSURE_ENGINE_LINEAR)
+    return closureIterative(index, X, -1);
+
+  attrset closure;
+  linearClosure(index, scratch, X, NULL, -1, &closure);
   return closure;
-}
\ No newline at end of file
+}
+
+int closureImplies(ClosureIndex *index, attrset X, attrset Y)
+{
+  return closureImpliesWithScratch(index, &index->scratch, X, Y, -1);
+}
+
+int closureImpliesWithScratch(const ClosureIndex *index, ClosureScratch *scratch, attrset X, attrset Y,
+                              int skipFd)
+{
+  if (currentEngine != CLOSURE_ENGINE_LINEAR)
+    return attrsetIsSubset(Y, closureIterative(index, X, skipFd));
+
+  attrset closure;
+  return linearClosure(index, scratch, X, &Y, skipFd, &closure);
+}
+
+/* -----------------------------------------------------------------------------
+   Fecho em lote bit-sliced.
+   slices[a * words + w] guarda, para o atributo a, um bit por consulta:
+   a FD X -> Y dispara nas consultas em que todos os atributos de X estão
+   presentes (AND das fatias de X), e essas consultas recebem Y (OR nas
+   fatias de Y).
+
+   Depois de uma passada sobre F, o ponto fixo é dirigido por uma fila de
+   atributos: delta[a] guarda as consultas que ganharam a desde que a saiu
+   da fila, e só as FDs da lista de a são reavaliadas, restritas a essas
+   consultas. Uma FD volta a ser
+   olhada apenas quando algum atributo do seu LHS ganha bits, e o custo não
+   depende mais de quantas passadas sobre F uma cadeia longa exigiria. A
+   fila é varrida na ordem de attrRank, para juntar os bits de todos os
+   predecessores antes de propagar um atributo.
+ ----------------------------------------------------------------------------- */
+static ClosureBatchKernel currentBatchKernel = CLOSURE_BATCH_AUTO;
+
+void setClosureBatchKernel(ClosureBatchKernel kernel)
+{
+  currentBatchKernel = kernel;
+}
+
+ClosureBatchKernel getClosureBatchKernel(void)
+{
+  return currentBatchKernel;
+}
+
+#define CLOSURE_BATCH_MAX_WORDS 4
+// Passadas sobre F antes de o ponto fixo passar para a fila de atributos
+#define CLOSURE_BATCH_MAX_PASSES 4
+
+// Aplica a FD i às consultas de fire; atributos ganhos vão para a fila
+static inline __attribute__((always_inline)) void slicedFire(const ClosureIndex *index, int i,
+                                                            uint64_t *slices, uint64_t *delta,
+                                                            int words, const uint64_t *fire,
+                                                            uint64_t *pending)
+{
+  for (int k = index->fdRhsStart[i]; k < index->fdRhsStart[i + 1]; ++k)
+  {
+    int a = index->fdRhsAttrs[k];
+    uint64_t *slice = slices + (size_t)a * words;
+    uint64_t added[CLOSURE_BATCH_MAX_WORDS];
+    uint64_t any = 0;
+    for (int w = 0; w < words; ++w)
+    {
+      added[w] = fire[w] & ~slice[w];
+      slice[w] |= added[w];
+      any |= added[w];
+    }
+
+    // Atributos fora de todo LHS não reativam FD nenhuma
+    if (!any || a >= index->attrCount)
+      continue;
+
+    for (int w = 0; w < words; ++w)
+      delta[(size_t)a * words + w] |= added[w];
+    int rank = index->attrRank[a];
+    pending[rank >> 6] |= (uint64_t)1 << (rank & 63);
+  }
+}
+
+/* Restringe fire às consultas em que o LHS da FD i (menos b, já garantido
+   em fire) está todo presente. Retorna 0 se não sobra nenhuma. O AND vai do
+   maior atributo do LHS para o menor: num LHS longo, os que ainda faltam
+   costumam ser os últimos, e a FD sai no primeiro passo. */
+static inline __attribute__((always_inline)) uint64_t slicedLhs(const ClosureIndex *index, int i, int b,
+                                                                const uint64_t *slices, int words,
+                                                                uint64_t *fire)
+{
+  uint64_t any = 0;
+  for (int w = 0; w < words; ++w)
+    any |= fire[w];
+
+  for (int k = index->fdLhsStart[i + 1] - 1; k >= index->fdLhsStart[i] && any; --k)
+  {
+    int a = index->fdLhsAttrs[k];
+    if (a == b)
+      continue;
+
+    const uint64_t *slice = slices + (size_t)a * words;
+    any = 0;
+    for (int w = 0; w < words; ++w)
+    {
+      fire[w] &= slice[w];
+      any |= fire[w];
+    }
+  }
+
+  return any;
+}
+
+// Restringe fire às consultas em que ainda falta parte do RHS da FD i
+static inline __attribute__((always_inline)) uint64_t slicedMissingRhs(const ClosureIndex *index, int i,
+                                                                       const uint64_t *slices, int words,
+                                                                       uint64_t *fire)
+{
+  uint64_t covered[CLOSURE_BATCH_MAX_WORDS];
+  for (int w = 0; w < words; ++w)
+    covered[w] = ~(uint64_t)0;
+
+  for (int k = index->fdRhsStart[i]; k < index->fdRhsStart[i + 1]; ++k)
+  {
+    const uint64_t *slice = slices + (size_t)index->fdRhsAttrs[k] * words;
+    for (int w = 0; w < words; ++w)
+      covered[w] &= slice[w];
+  }
+
+  uint64_t any = 0;
+  for (int w = 0; w < words; ++w)
+  {
+    fire[w] &= ~covered[w];
+    any |= fire[w];
+  }
+  return any;
+}
+
+// Retorna o número de passadas sobre F
+static inline __attribute__((always_inline)) int slicedFixpoint(const ClosureIndex *index,
+                                                                uint64_t *slices, int words,
+                                                                const uint64_t *active)
+{
+  uint64_t delta[ATTRSET_MAX_ATTRS * CLOSURE_BATCH_MAX_WORDS];
+  uint64_t pending[ATTRSET_MAX_WORDS]; // fila: um bit por posição em attrRank
+  int pendingWords = (index->attrCount + 63) >> 6;
+  int passes = 0;
+
+  /* Passadas sobre F enquanto forem mais baratas que a fila: cada uma olha
+     toda FD uma vez. O que os atributos de LHS ganharam durante a última
+     (fatias depois menos fatias antes) vira delta. */
+  size_t lhsWords = (size_t)index->attrCount * words;
+  for (;;)
+  {
+    memcpy(delta, slices, sizeof(uint64_t) * lhsWords);
+    passes++;
+
+    int changed = 0;
+    for (int i = 0; i < index->fdCount; ++i)
+    {
+      if (!index->enabled[i])
+        continue;
+
+      uint64_t fire[CLOSURE_BATCH_MAX_WORDS];
+      memcpy(fire, active, sizeof(uint64_t) * words);
+      if (!slicedLhs(index, i, -1, slices, words, fire))
+        continue;
+
+      for (int k = index->fdRhsStart[i]; k < index->fdRhsStart[i + 1]; ++k)
+      {
+        uint64_t *slice = slices + (size_t)index->fdRhsAttrs[k] * words;
+        uint64_t added = 0;
+        for (int w = 0; w < words; ++w)
+        {
+          added |= fire[w] & ~slice[w];
+          slice[w] |= fire[w];
+        }
+        if (added)
+          changed = 1;
+      }
+    }
+
+    if (!changed)
+      return passes;
+
+    /* Custo da fila: as listas dos atributos que ainda vão propagar */
+    int queued = 0;
+    memset(pending, 0, sizeof(pending));
+    for (int a = 0; a < index->attrCount; ++a)
+    {
+      uint64_t any = 0;
+      for (int w = 0; w < words; ++w)
+      {
+        delta[(size_t)a * words + w] = slices[(size_t)a * words + w] & ~delta[(size_t)a * words + w];
+        any |= delta[(size_t)a * words + w];
+      }
+      if (!any)
+        continue;
+
+      int rank = index->attrRank[a];
+      pending[rank >> 6] |= (uint64_t)1 << (rank & 63);
+      queued += index->listEnd[a] - index->listStart[a];
+    }
+
+    if (queued == 0)
+      return passes;
+    if (queued < index->fdCount || passes == CLOSURE_BATCH_MAX_PASSES)
+      break;
+  }
+
+  /* Varreduras em ordem de attrRank: um atributo que ganha bits adiante
+     do cursor entra nesta varredura, um que ficou para trás, na próxima */
+  int cursor = 0;
+  for (;;)
+  {
+    int word = cursor >> 6;
+    uint64_t bits = word < pendingWords ? pending[word] & (~(uint64_t)0 << (cursor & 63)) : 0;
+    while (!bits && ++word < pendingWords)
+      bits = pending[word];
+
+    if (!bits)
+    {
+      if (cursor == 0)
+        break;
+      cursor = 0;
+      continue;
+    }
+
+    int rank = (word << 6) + __builtin_ctzll(bits);
+    pending[word] &= ~((uint64_t)1 << (rank & 63));
+    cursor = rank + 1;
+    int b = index->rankAttr[rank];
+
+    uint64_t gained[CLOSURE_BATCH_MAX_WORDS];
+    for (int w = 0; w < words; ++w)
+    {
+      gained[w] = delta[(size_t)b * words + w];
+      delta[(size_t)b * words + w] = 0;
+    }
+
+    /* Só as consultas que acabaram de ganhar b podem disparar as FDs da
+       lista de b de novo. Nelas o LHS costuma já estar completo: o RHS
+       que falta é o filtro mais barato, e vem antes. */
+    for (int j = index->listStart[b]; j < index->listEnd[b]; ++j)
+    {
+      int i = index->listFds[j];
+      if (!index->enabled[i])
+        continue;
+
+      uint64_t fire[CLOSURE_BATCH_MAX_WORDS];
+      memcpy(fire, gained, sizeof(uint64_t) * words);
+      if (slicedMissingRhs(index, i, slices, words, fire) && slicedLhs(index, i, b, slices, words, fire))
+        slicedFire(index, i, slices, delta, words, fire, pending);
+    }
+  }
+
+  return passes;
+}
+
+static int slicedFixpointScalar(const ClosureIndex *index, uint64_t *slices, const uint64_t *active)
+{
+  return slicedFixpoint(index, slices, 1, active);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static int slicedFixpointAvx2(const ClosureIndex *index, uint64_t *slices,
+                                                              const uint64_t *active)
+{
+  return slicedFixpoint(index, slices, 4, active);
+}
+
+/* Detectado uma vez: lotes são fechados em várias threads ao mesmo tempo */
+static int hasAvx2 = 0;
+static pthread_once_t avx2Once = PTHREAD_ONCE_INIT;
+
+static void detectAvx2(void)
+{
+  __builtin_cpu_init();
+  hasAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+static int cpuHasAvx2(void)
+{
+  pthread_once(&avx2Once, detectAvx2);
+  return hasAvx2;
+}
+#endif
+
+// Palavras de 64 consultas por passada: 4 (AVX2) ou 1 (escalar)
+static int batchWords(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (currentBatchKernel == CLOSURE_BATCH_AVX2 ||
+      (currentBatchKernel == CLOSURE_BATCH_AUTO && cpuHasAvx2()))
+    return 4;
+#endif
+  return 1;
+}
+
+// Um bloco de até 64 * words consultas
+static void closureBlock(const ClosureIndex *index, const attrset *X, attrset *out, int count, int words)
+{
+  int attrCount = index->fdAttrCount;
+  uint64_t slices[ATTRSET_MAX_ATTRS * CLOSURE_BATCH_MAX_WORDS];
+  uint64_t active[CLOSURE_BATCH_MAX_WORDS] = {0};
+
+  memset(slices, 0, sizeof(uint64_t) * (size_t)attrCount * words);
+  for (int q = 0; q < count; ++q)
+    active[q >> 6] |= (uint64_t)1 << (q & 63);
+
+  /* Transpõe: consulta -> fatias por atributo */
+  for (int q = 0; q < count; ++q)
+  {
+    uint64_t bit = (uint64_t)1 << (q & 63);
+    for (int a = attrsetNext(X[q], 0); a >= 0 && a < attrCount; a = attrsetNext(X[q], a + 1))
+      slices[(size_t)a * words + (q >> 6)] |= bit;
+  }
+
+  int passes;
+#if defined(__x86_64__) || defined(__i386__)
+  if (words == 4)
+    passes = slicedFixpointAvx2(index, slices, active);
+  else
+#endif
+    passes = slicedFixpointScalar(index, slices, active);
+  STATS_COUNT(STAT_FIXPOINT_ITERATIONS, passes);
+
+  /* Transpõe de volta; atributos fora das FDs só são copiados */
+  for (int q = 0; q < count; ++q)
+    out[q] = X[q];
+
+  for (int a = 0; a < attrCount; ++a)
+  {
+    for (int w = 0; w < words; ++w)
+    {
+      uint64_t lanes = slices[(size_t)a * words + w];
+      while (lanes)
+      {
+        int q = (w << 6) + __builtin_ctzll(lanes);
+        lanes &= lanes - 1;
+        attrsetInsert(&out[q], a);
+      }
+    }
+  }
+}
+
+void computeClosureBatch(const ClosureIndex *index, const attrset *X, attrset *out, int count)
+{
+  /* Os motores iterativos valem também para os lotes */
+  if (currentEngine != CLOSURE_ENGINE_LINEAR)
+  {
+    for (int q = 0; q < count; ++q)
+      out[q] = closureIterative(index, X[q], -1);
+    return;
+  }
+
+  if (currentBatchKernel == CLOSURE_BATCH_OFF)
+  {
+    ClosureScratch scratch;
+    if (initClosureScratch(&scratch, index) == 0)
+    {
+      for (int q = 0; q < count; ++q)
+        out[q] = computeClosureWithScratch(index, &scratch, X[q]);
+      freeClosureScratch(&scratch);
+      return;
+    }
+  }
+
+  STATS_COUNT(STAT_BATCH_CLOSURES, count);
+  int words = batchWords();
+  int lanes = 64 * words;
+
+  for (int begin = 0; begin < count; begin += lanes)
+  {
+    int blockCount = count - begin < lanes ? count - begin : lanes;
+    closureBlock(index, X + begin, out + begin, blockCount, words);
+  }
+}
+
+/* -----------------------------------------------------------------------------
+   Lote repartido entre threads: cada uma fecha uma fatia contígua. Se a
+   criação de uma thread falhar, a fatia é fechada na thread chamadora.
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  const ClosureIndex *index;
+  const attrset *X;
+  attrset *out;
+  int count;
+  int attrWords;
+} BatchSlice;
+
+static void *batchSliceMain(void *arg)
+{
+  BatchSlice *slice = arg;
+  attrsetUseWords(slice->attrWords);
+  computeClosureBatch(slice->index, slice->X, slice->out, slice->count);
+  return NULL;
+}
+
+void computeClosureBatchParallel(const ClosureIndex *index, const attrset *X, attrset *out, int count,
+                                 int threads)
+{
+  if (threads > count)
+    threads = count;
+  if (threads <= 1)
+  {
+    computeClosureBatch(index, X, out, count);
+    return;
+  }
+
+  BatchSlice slices[threads];
+  pthread_t handles[threads];
+  char started[threads];
+
+  for (int t = 0; t < threads; ++t)
+  {
+    int begin = (int)((long long)count * t / threads);
+    int end = (int)((long long)count * (t + 1) / threads);
+    slices[t].index = index;
+    slices[t].X = X + begin;
+    slices[t].out = out + begin;
+    slices[t].count = end - begin;
+    slices[t].attrWords = activeAttrsetWords();
+
+    started[t] = pthread_create(&handles[t], NULL, batchSliceMain, &slices[t]) == 0;
+    if (!started[t])
+      batchSliceMain(&slices[t]);
+  }
+
+  for (int t = 0; t < threads; ++t)
+    if (started[t])
+      pthread_join(handles[t], NULL);
+}
@@ -3,7 +3,147 @@
 
 #include <stdint.h>
 #include "parser.h"
+#include "fdtable.h"
+
+/* Motor usado pelas consultas indexadas:
+     LINEAR — LINCLOSURE (contadores de atributos faltantes por FD)
+     NAIVE  — laço original, repetido até não haver mudança (referência)
+     TABLE  — o mesmo laço sobre a FdTable do índice, com o teste
+              LHS ⊆ fecho vetorizado; sem tabela (ou com FDs desativadas),
+              o laço original */
+typedef enum
+{
+  CLOSURE_ENGINE_LINEAR,
+  CLOSURE_ENGINE_NAIVE,
+  CLOSURE_ENGINE_TABLE
+} ClosureEngine;
+
+/* Memória de trabalho de uma consulta: contadores válidos apenas quando
+   stamp == epoch. Cada thread usa a sua; o índice em si é só leitura. */
+typedef struct
+{
+  int *counter;
+  unsigned *stamp;
+  unsigned epoch;
+  int size;
+} ClosureScratch;
+
+/* Índice de um conjunto de FDs para cálculo de fecho em tempo linear.
+   Construído uma vez por conjunto de FDs e reutilizado por todas as
+   consultas. */
+typedef struct
+{
+  int fdCount;
+  attrset *lhs;
+  attrset *rhs;
+  int *lhsSize;   // |LHS| de cada FD
+  char *enabled;  // FDs desativadas não disparam
+  int disabledCount;
+
+  /* Tabela SoA das FDs, quando o índice foi montado a partir dela */
+  FdTable *table;
+
+  /* Lista atributo -> FDs cujo LHS contém o atributo (formato CSR) */
+  int attrCount;  // maior atributo presente em algum LHS + 1
+  int *listStart; // attrCount + 1 posições
+  int *listEnd;   // fim de cada lista (recua quando uma FD é removida)
+  int *listFds;
+
+  /* Atributos de cada FD em listas (CSR), usados pelo fecho em lote */
+  int fdAttrCount; // maior atributo presente em alguma FD + 1
+  int *fdLhsStart;
+  int *fdLhsAttrs;
+  int *fdRhsStart;
+  int *fdRhsAttrs;
+
+  /* FDs com LHS vazio disparam sempre */
+  int *emptyLhsFds;
+  int emptyLhsCount;
+
+  /* Ordem em que o fecho em lote propaga os atributos de LHS (ordem
+     topológica do grafo LHS -> RHS, quando não há ciclos): attrRank[a] é
+     a posição de a, rankAttr o inverso. Sempre do índice, mesmo emprestado. */
+  int *attrRank;
+  int *rankAttr;
+
+  /* Memória de trabalho das consultas de uma só thread */
+  ClosureScratch scratch;
+
+  /* Identifica o conjunto de FDs ativas: único entre índices e trocado a
+     cada FD ativada/desativada/removida (chave dos caches de fecho) */
+  uint64_t version;
+
+  /* Vetores só de leitura emprestados (wrapClosureIndex): não são
+     liberados por freeClosureIndex */
+  int borrowed;
+} ClosureIndex;
 
 attrset computeClosure(attrset X, FD *fds, int nfds);
 
-#endif
\ No newline at end of file
+void setClosureEngine(ClosureEngine engine);
+ClosureEngine getClosureEngine(void);
+
+ClosureIndex *buildClosureIndex(const FD *fds, int fdCount);
+
+/* Índice sobre a FdTable das FDs (LHS iguais juntados, FDs triviais fora).
+   Equivalente para o fecho, mas as posições não correspondem às de fds:
+   para quem só consulta fechos, sem desativar FDs individuais. */
+ClosureIndex *buildMergedClosureIndex(const FD *fds, int fdCount);
+void freeClosureIndex(ClosureIndex *index);
+
+/* Índice sobre vetores já montados (ex: mapeados de um .fdb). shape traz
+   fdCount, attrCount, fdAttrCount, emptyLhsCount e os vetores lhs, rhs,
+   lhsSize, listStart, listFds, emptyLhsFds e fd{Lhs,Rhs}{Start,Attrs},
+   que são usados sem cópia e continuam sendo de quem chama. Só o estado
+   mutável (FDs ativas, fim das listas, scratch) é alocado; todas as FDs
+   começam ativas. removeClosureIndexFd escreve em listFds. */
+ClosureIndex *wrapClosureIndex(const ClosureIndex *shape);
+
+// Ativa/desativa a FD i sem reconstruir o índice
+void setClosureIndexFd(ClosureIndex *index, int i, int enabled);
+
+// Remove a FD i de vez: desativa e a tira das listas, sem reconstruir
+void removeClosureIndexFd(ClosureIndex *index, int i);
+
+attrset computeClosureIndexed(ClosureIndex *index, attrset X);
+
+// 1 se Y ⊆ X+; o fecho para assim que alcança Y
+int closureImplies(ClosureIndex *index, attrset X, attrset Y);
+
+/* Núcleo do fecho em lote (bit-sliced):
+     AUTO   — AVX2 (256 consultas por passada) se a CPU suportar,
+              senão escalar (64 por passada)
+     SCALAR — sempre 64 consultas por passada
+     AVX2   — força 256 por passada
+     OFF    — uma consulta por vez, pelo motor configurado */
+typedef enum
+{
+  CLOSURE_BATCH_AUTO,
+  CLOSURE_BATCH_SCALAR,
+  CLOSURE_BATCH_AVX2,
+  CLOSURE_BATCH_OFF
+} ClosureBatchKernel;
+
+void setClosureBatchKernel(ClosureBatchKernel kernel);
+ClosureBatchKernel getClosureBatchKernel(void);
+
+/* Fecha count conjuntos de uma vez (out[i] = X[i]+); out pode ser X.
+   Os conjuntos são transpostos em fatias por atributo, de modo que cada
+   passada sobre F avança 64 ou 256 fechos juntos. Seguro entre threads. */
+void computeClosureBatch(const ClosureIndex *index, const attrset *X, attrset *out, int count);
+
+// computeClosureBatch repartido entre threads (threads <= 1: na chamadora)
+void computeClosureBatchParallel(const ClosureIndex *index, const attrset *X, attrset *out, int count,
+                                 int threads);
+
+/* Consultas concorrentes sobre o mesmo índice: uma scratch por thread */
+int initClosureScratch(ClosureScratch *scratch, const ClosureIndex *index);
+void freeClosureScratch(ClosureScratch *scratch);
+attrset computeClosureWithScratch(const ClosureIndex *index, ClosureScratch *scratch, attrset X);
+
+/* closureImplies com scratch própria, ignorando a FD skipFd (-1 = nenhuma)
+   sem mexer nas flags do índice: testes de redundância concorrentes */
+int closureImpliesWithScratch(const ClosureIndex *index, ClosureScratch *scratch, attrset X, attrset Y,
+                              int skipFd);
+
+#endif
@@ -0,0 +1,195 @@
+#include "closurecache.h"
+#include "arena.h"
+#include "stats.h"
+#include <stdlib.h>
+
+static size_t currentEntries = CLOSURE_CACHE_DEFAULT_ENTRIES;
+
+void setClosureCacheEntries(size_t entries)
+{
+  currentEntries = entries;
+}
+
+size_t getClosureCacheEntries(void)
+{
+  return currentEntries;
+}
+
+ClosureCache *createClosureCache(size_t capacity)
+{
+  size_t rounded = CLOSURE_CACHE_PROBE;
+  while (rounded < capacity)
+    rounded *= 2;
+
+  ClosureCache *cache = calloc(1, sizeof(ClosureCache));
+  if (!cache)
+    return NULL;
+
+  cache->capacity = rounded;
+  cache->entries = malloc(sizeof(ClosureCacheEntry) * rounded);
+  cache->used = calloc(rounded, 1);
+  cache->referenced = calloc(rounded, 1);
+
+  if (!cache->entries || !cache->used || !cache->referenced)
+  {
+    freeClosureCache(cache);
+    return NULL;
+  }
+  return cache;
+}
+
+void freeClosureCache(ClosureCache *cache)
+{
+  if (!cache)
+    return;
+
+  free(cache->entries);
+  free(cache->used);
+  free(cache->referenced);
+  free(cache);
+}
+
+static size_t cacheSlot(const ClosureCache *cache, uint64_t version, attrset X)
+{
+  /* Finalizador do splitmix64: os bits baixos dependem de todos */
+  uint64_t h = attrsetHash(X) ^ (version * 0x9e3779b97f4a7c15ull);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  return (size_t)(h ^ (h >> 31)) & (cache->capacity - 1);
+}
+
+int closureCacheLookup(ClosureCache *cache, const ClosureIndex *index, attrset X, attrset *out)
+{
+  size_t home = cacheSlot(cache, index->version, X);
+
+  for (int p = 0; p < CLOSURE_CACHE_PROBE; ++p)
+  {
+    size_t slot = (home + p) & (cache->capacity - 1);
+    if (!cache->used[slot])
+      break;
+
+    ClosureCacheEntry *entry = &cache->entries[slot];
+    if (entry->version == index->version && attrsetEquals(entry->X, X))
+    {
+      cache->referenced[slot] = 1;
+      cache->hits++;
+      STATS_COUNT(STAT_CACHE_HITS, 1);
+      *out = entry->closure;
+      return 1;
+    }
+  }
+
+  cache->misses++;
+  STATS_COUNT(STAT_CACHE_MISSES, 1);
+  return 0;
+}
+
+void closureCacheStore(ClosureCache *cache, const ClosureIndex *index, attrset X, attrset closure)
+{
+  size_t home = cacheSlot(cache, index->version, X);
+  size_t victim = home;
+  int found = 0;
+
+  /* Mesma chave ou posição livre dentro da janela */
+  for (int p = 0; p < CLOSURE_CACHE_PROBE && !found; ++p)
+  {
+    size_t slot = (home + p) & (cache->capacity - 1);
+    if (!cache->used[slot])
+    {
+      cache->used[slot] = 1;
+      cache->count++;
+      victim = slot;
+      found = 1;
+    }
+    else if (cache->entries[slot].version == index->version && attrsetEquals(cache->entries[slot].X, X))
+    {
+      victim = slot;
+      found = 1;
+    }
+  }
+
+  /* Janela cheia: o relógio dá uma volta tirando as segundas chances
+     e para na primeira entrada não usada desde a volta anterior */
+  if (!found)
+  {
+    for (int step = 0; step < 2 * CLOSURE_CACHE_PROBE; ++step)
+    {
+      size_t slot = (home + (cache->hand++ % CLOSURE_CACHE_PROBE)) & (cache->capacity - 1);
+      if (!cache->referenced[slot])
+      {
+        victim = slot;
+        break;
+      }
+      cache->referenced[slot] = 0;
+    }
+    cache->evictions++;
+    STATS_COUNT(STAT_CACHE_EVICTIONS, 1);
+  }
+
+  cache->entries[victim].version = index->version;
+  cache->entries[victim].X = X;
+  cache->entries[victim].closure = closure;
+  cache->referenced[victim] = 0;
+}
+
+attrset cachedClosure(ClosureCache *cache, ClosureIndex *index, attrset X)
+{
+  attrset closure;
+  if (closureCacheLookup(cache, index, X, &closure))
+    return closure;
+
+  closure = computeClosureIndexed(index, X);
+  closureCacheStore(cache, index, X, closure);
+  return closure;
+}
+
+void cachedClosureBatch(ClosureCache *cache, const ClosureIndex *index, const attrset *X, attrset *out,
+                        int count, int threads)
+{
+  Arena *scratch = getScratchArena();
+  int *missing = scratchAlloc(scratch, sizeof(int) * (count > 0 ? count : 1));
+  attrset *pending = scratchAlloc(scratch, sizeof(attrset) * (count > 0 ? count : 1));
+
+  /* Sem memória para separar as faltas: fecha tudo, sem cache */
+  if (!missing || !pending)
+  {
+    scratchFree(scratch, missing);
+    scratchFree(scratch, pending);
+    computeClosureBatchParallel(index, X, out, count, threads);
+    return;
+  }
+
+  int missCount = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    attrset closure;
+    if (closureCacheLookup(cache, index, X[i], &closure))
+      out[i] = closure;
+    else
+    {
+      missing[missCount] = i;
+      pending[missCount++] = X[i];
+    }
+  }
+
+  if (missCount > 0)
+    computeClosureBatchParallel(index, pending, pending, missCount, threads);
+
+  for (int k = 0; k < missCount; ++k)
+  {
+    closureCacheStore(cache, index, X[missing[k]], pending[k]);
+    out[missing[k]] = pending[k];
+  }
+
+  scratchFree(scratch, missing);
+  scratchFree(scratch, pending);
+}
+
+void fprintClosureCacheStats(FILE *out, const char *label, const ClosureCache *cache)
+{
+  uint64_t lookups = cache->hits + cache->misses;
+  fprintf(out, "%s: closure cache %llu hits, %llu misses (%.1f%% hit rate), %llu evictions, %zu/%zu entries\n",
+          label, (unsigned long long)cache->hits, (unsigned long long)cache->misses,
+          lookups ? 100.0 * (double)cache->hits / (double)lookups : 0.0, (unsigned long long)cache->evictions,
+          cache->count, cache->capacity);
+}
@@ -0,0 +1,72 @@
+#ifndef CLOSURECACHE_H
+#define CLOSURECACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "attrset.h"
+#include "closure.h"
+
+/* -----------------------------------------------------------------------------
+   Cache de fechos, chaveado por (versão do índice, X).
+
+   Tabela de tamanho fixo com endereçamento aberto: cada X só pode ocupar as
+   CLOSURE_CACHE_PROBE posições a partir do seu hash. Com a janela cheia, a
+   vítima é escolhida pelo relógio (clock): entradas usadas desde a última
+   volta ganham uma segunda chance. Posições nunca voltam a ficar livres, só
+   são sobrescritas, então a sondagem para na primeira posição livre.
+
+   A versão do ClosureIndex muda quando o conjunto de FDs ativas muda, então
+   entradas antigas simplesmente deixam de ser encontradas e saem pelo
+   relógio. O mesmo cache pode ser usado com vários índices.
+
+   Não é seguro entre threads: uma instância por thread.
+ ----------------------------------------------------------------------------- */
+#define CLOSURE_CACHE_PROBE 8
+#define CLOSURE_CACHE_DEFAULT_ENTRIES 4096
+
+typedef struct
+{
+  uint64_t version;
+  attrset X;
+  attrset closure;
+} ClosureCacheEntry;
+
+typedef struct
+{
+  ClosureCacheEntry *entries;
+  unsigned char *used;
+  unsigned char *referenced; // bit do relógio
+  size_t capacity;           // potência de 2
+  size_t count;
+  unsigned hand;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} ClosureCache;
+
+/* Entradas dos caches criados pelos módulos (0 = sem cache) */
+void setClosureCacheEntries(size_t entries);
+size_t getClosureCacheEntries(void);
+
+// capacity é arredondada para potência de 2 (mínimo CLOSURE_CACHE_PROBE)
+ClosureCache *createClosureCache(size_t capacity);
+void freeClosureCache(ClosureCache *cache);
+
+// 1 e *out = X+ se está no cache
+int closureCacheLookup(ClosureCache *cache, const ClosureIndex *index, attrset X, attrset *out);
+void closureCacheStore(ClosureCache *cache, const ClosureIndex *index, attrset X, attrset closure);
+
+// X+ pelo cache; calcula e guarda se faltar
+attrset cachedClosure(ClosureCache *cache, ClosureIndex *index, attrset X);
+
+/* Fecha count conjuntos: os que faltam no cache são fechados juntos em
+   lote (computeClosureBatchParallel) e guardados. out pode ser X. */
+void cachedClosureBatch(ClosureCache *cache, const ClosureIndex *index, const attrset *X, attrset *out,
+                        int count, int threads);
+
+// Uma linha com acertos, faltas, taxa de acerto e despejos
+void fprintClosureCacheStats(FILE *out, const char *label, const ClosureCache *cache);
+
+#endif
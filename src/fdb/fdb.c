@@ -0,0 +1,584 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fdb.h"
+#include "catalog.h"
+#include "stats.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ---------------------------------------------------------------
+   Layout do arquivo
+---------------------------------------------------------------- */
+#define FDB_MAGIC "FDTOOLDB"
+#define FDB_MAGIC_SIZE 8
+#define FDB_BYTE_ORDER 0x01020304u
+#define FDB_ALIGN 64
+
+enum
+{
+  FDB_HAS_COVER = 1,
+  FDB_HAS_KEYS = 2,
+  FDB_HAS_INDEX = 4
+};
+
+enum
+{
+  FDB_NAMES,
+  FDB_UNIVERSE,
+  FDB_FDS,
+  FDB_COVER,
+  FDB_KEYS,
+  FDB_INDEX_LHS,
+  FDB_INDEX_RHS,
+  FDB_INDEX_LHS_SIZE,
+  FDB_INDEX_LIST_START,
+  FDB_INDEX_LIST_FDS,
+  FDB_INDEX_EMPTY_LHS,
+  FDB_INDEX_FD_LHS_START,
+  FDB_INDEX_FD_LHS_ATTRS,
+  FDB_INDEX_FD_RHS_START,
+  FDB_INDEX_FD_RHS_ATTRS,
+  FDB_SECTION_COUNT
+};
+
+typedef struct
+{
+  uint64_t offset;
+  uint64_t size;
+} FdbSection;
+
+typedef struct
+{
+  char magic[FDB_MAGIC_SIZE];
+  uint32_t formatVersion;
+  uint32_t byteOrder;
+  uint32_t setWords; // ATTRSET_MAX_WORDS de quem gravou
+  uint32_t attrCount;
+  uint32_t flags;
+
+  int32_t fdCount;
+  int32_t coverCount;
+  int32_t keyCount;
+
+  /* Campos escalares do ClosureIndex gravado */
+  int32_t indexFdCount;
+  int32_t indexAttrCount;
+  int32_t indexFdAttrCount;
+  int32_t indexEmptyLhsCount;
+
+  FdbSection sections[FDB_SECTION_COUNT];
+} FdbHeader;
+
+static uint64_t alignUp(uint64_t offset)
+{
+  return (offset + FDB_ALIGN - 1) & ~(uint64_t)(FDB_ALIGN - 1);
+}
+
+/* ---------------------------------------------------------------
+   Escrita
+---------------------------------------------------------------- */
+static int writePadding(FILE *out, uint64_t from, uint64_t to)
+{
+  static const char zeros[FDB_ALIGN] = {0};
+  return to > from && fwrite(zeros, 1, (size_t)(to - from), out) != (size_t)(to - from) ? -1 : 0;
+}
+
+int writeFdbFile(const char *path, const AttrDict *dict, const FdSchema *schema)
+{
+  const ClosureIndex *index = schema->cover ? schema->closureIndex : NULL;
+  if (index && index->disabledCount > 0)
+  {
+    fprintf(stderr, "Error: cannot store a closure index with disabled FDs\n");
+    return -1;
+  }
+
+  /* Nomes em sequência, cada um terminado em '\0' */
+  size_t namesSize = 0;
+  for (int i = 0; i < dict->count; ++i)
+    namesSize += strlen(dict->names[i]) + 1;
+
+  char *names = malloc(namesSize > 0 ? namesSize : 1);
+  if (!names)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+
+  size_t fill = 0;
+  for (int i = 0; i < dict->count; ++i)
+  {
+    size_t length = strlen(dict->names[i]) + 1;
+    memcpy(names + fill, dict->names[i], length);
+    fill += length;
+  }
+
+  FdbHeader header;
+  memset(&header, 0, sizeof(FdbHeader));
+  memcpy(header.magic, FDB_MAGIC, FDB_MAGIC_SIZE);
+  header.formatVersion = FDB_FORMAT_VERSION;
+  header.byteOrder = FDB_BYTE_ORDER;
+  header.setWords = ATTRSET_MAX_WORDS;
+  header.attrCount = (uint32_t)dict->count;
+  header.fdCount = schema->fdCount;
+
+  const void *data[FDB_SECTION_COUNT] = {0};
+  data[FDB_NAMES] = names;
+  header.sections[FDB_NAMES].size = namesSize;
+  data[FDB_UNIVERSE] = &schema->U;
+  header.sections[FDB_UNIVERSE].size = sizeof(attrset);
+  data[FDB_FDS] = schema->fds;
+  header.sections[FDB_FDS].size = sizeof(FD) * (size_t)schema->fdCount;
+
+  if (schema->cover)
+  {
+    header.flags |= FDB_HAS_COVER;
+    header.coverCount = schema->coverCount;
+    data[FDB_COVER] = schema->cover;
+    header.sections[FDB_COVER].size = sizeof(FD) * (size_t)schema->coverCount;
+  }
+
+  if (schema->keys)
+  {
+    header.flags |= FDB_HAS_KEYS;
+    header.keyCount = schema->keyCount;
+    data[FDB_KEYS] = schema->keys;
+    header.sections[FDB_KEYS].size = sizeof(attrset) * (size_t)schema->keyCount;
+  }
+
+  if (index)
+  {
+    size_t n = (size_t)index->fdCount;
+    header.flags |= FDB_HAS_INDEX;
+    header.indexFdCount = index->fdCount;
+    header.indexAttrCount = index->attrCount;
+    header.indexFdAttrCount = index->fdAttrCount;
+    header.indexEmptyLhsCount = index->emptyLhsCount;
+
+    data[FDB_INDEX_LHS] = index->lhs;
+    header.sections[FDB_INDEX_LHS].size = sizeof(attrset) * n;
+    data[FDB_INDEX_RHS] = index->rhs;
+    header.sections[FDB_INDEX_RHS].size = sizeof(attrset) * n;
+    data[FDB_INDEX_LHS_SIZE] = index->lhsSize;
+    header.sections[FDB_INDEX_LHS_SIZE].size = sizeof(int) * n;
+    data[FDB_INDEX_LIST_START] = index->listStart;
+    header.sections[FDB_INDEX_LIST_START].size = sizeof(int) * (size_t)(index->attrCount + 1);
+    data[FDB_INDEX_LIST_FDS] = index->listFds;
+    header.sections[FDB_INDEX_LIST_FDS].size = sizeof(int) * (size_t)index->listStart[index->attrCount];
+    data[FDB_INDEX_EMPTY_LHS] = index->emptyLhsFds;
+    header.sections[FDB_INDEX_EMPTY_LHS].size = sizeof(int) * (size_t)index->emptyLhsCount;
+    data[FDB_INDEX_FD_LHS_START] = index->fdLhsStart;
+    header.sections[FDB_INDEX_FD_LHS_START].size = sizeof(int) * (n + 1);
+    data[FDB_INDEX_FD_LHS_ATTRS] = index->fdLhsAttrs;
+    header.sections[FDB_INDEX_FD_LHS_ATTRS].size = sizeof(int) * (size_t)index->fdLhsStart[n];
+    data[FDB_INDEX_FD_RHS_START] = index->fdRhsStart;
+    header.sections[FDB_INDEX_FD_RHS_START].size = sizeof(int) * (n + 1);
+    data[FDB_INDEX_FD_RHS_ATTRS] = index->fdRhsAttrs;
+    header.sections[FDB_INDEX_FD_RHS_ATTRS].size = sizeof(int) * (size_t)index->fdRhsStart[n];
+  }
+
+  uint64_t offset = alignUp(sizeof(FdbHeader));
+  for (int s = 0; s < FDB_SECTION_COUNT; ++s)
+  {
+    header.sections[s].offset = offset;
+    offset = alignUp(offset + header.sections[s].size);
+  }
+
+  /* Arquivo temporário ao lado do destino, renomeado no fim */
+  size_t pathLength = strlen(path);
+  char *tempPath = malloc(pathLength + 5);
+  if (!tempPath)
+  {
+    free(names);
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+  memcpy(tempPath, path, pathLength);
+  memcpy(tempPath + pathLength, ".tmp", 5);
+
+  FILE *out = fopen(tempPath, "wb");
+  int status = out ? 0 : -1;
+
+  uint64_t written = sizeof(FdbHeader);
+  if (status == 0 && fwrite(&header, sizeof(FdbHeader), 1, out) != 1)
+    status = -1;
+
+  for (int s = 0; s < FDB_SECTION_COUNT && status == 0; ++s)
+  {
+    size_t size = (size_t)header.sections[s].size;
+    if (writePadding(out, written, header.sections[s].offset) != 0 ||
+        (size > 0 && fwrite(data[s], 1, size, out) != size))
+      status = -1;
+    written = header.sections[s].offset + size;
+  }
+
+  if (out && fclose(out) != 0)
+    status = -1;
+  if (status == 0 && rename(tempPath, path) != 0)
+    status = -1;
+
+  if (status != 0)
+  {
+    fprintf(stderr, "Error: cannot write %s\n", path);
+    remove(tempPath);
+  }
+
+  free(tempPath);
+  free(names);
+  return status;
+}
+
+/* ---------------------------------------------------------------
+   Leitura
+---------------------------------------------------------------- */
+int isFdbFile(const char *path)
+{
+  int fd = path ? open(path, O_RDONLY) : -1;
+  if (fd < 0)
+    return 0;
+
+  struct stat info;
+  char magic[FDB_MAGIC_SIZE];
+  int isFdb = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+              read(fd, magic, FDB_MAGIC_SIZE) == FDB_MAGIC_SIZE &&
+              memcmp(magic, FDB_MAGIC, FDB_MAGIC_SIZE) == 0;
+
+  close(fd);
+  return isFdb;
+}
+
+/* Seção s com exatamente count elementos de elementSize bytes, dentro do
+   arquivo; NULL se não confere */
+static void *sectionData(const FdSchema *schema, const FdbHeader *header, int s, size_t elementSize,
+                         uint64_t count)
+{
+  const FdbSection *section = &header->sections[s];
+  if (section->offset % FDB_ALIGN != 0 || section->size != elementSize * count ||
+      section->offset > schema->mappingSize || section->size > schema->mappingSize - section->offset)
+    return NULL;
+  return (char *)schema->mapping + section->offset;
+}
+
+static int loadNames(const FdSchema *schema, const FdbHeader *header, AttrDict *dict)
+{
+  const FdbSection *section = &header->sections[FDB_NAMES];
+  const char *names = sectionData(schema, header, FDB_NAMES, 1, section->size);
+  if (!names || dict->count != 0)
+    return -1;
+
+  /* O índice de cada nome precisa sair igual ao gravado */
+  size_t pos = 0;
+  for (uint32_t i = 0; i < header->attrCount; ++i)
+  {
+    const char *end = memchr(names + pos, '\0', (size_t)section->size - pos);
+    if (!end)
+      return -1;
+
+    size_t length = (size_t)(end - (names + pos));
+    if (internAttribute(dict, names + pos, length) != (int)i)
+      return -1;
+    pos += length + 1;
+  }
+
+  return pos == section->size ? 0 : -1;
+}
+
+/* Conjuntos só com atributos abaixo de limit, olhando todas as palavras
+   (as inativas precisam ser zero para quando a largura crescer) */
+static int setsWithin(const attrset *sets, uint64_t count, int limit)
+{
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    for (int w = 0; w < ATTRSET_MAX_WORDS; ++w)
+    {
+      int low = w * 64;
+      uint64_t allowed = limit <= low ? 0 : limit - low >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << (limit - low)) - 1;
+      if (sets[i].w[w] & ~allowed)
+        return 0;
+    }
+  }
+  return 1;
+}
+
+static int fdsWithin(const FD *fds, uint64_t count, int limit)
+{
+  for (uint64_t i = 0; i < count; ++i)
+    if (!setsWithin(&fds[i].lhs, 1, limit) || !setsWithin(&fds[i].rhs, 1, limit))
+      return 0;
+  return 1;
+}
+
+/* Vetor de início CSR: começa em 0, não decresce e termina em total */
+static int startsValid(const int *start, int count, int total)
+{
+  if (start[0] != 0 || start[count] != total)
+    return 0;
+  for (int i = 0; i < count; ++i)
+    if (start[i] > start[i + 1])
+      return 0;
+  return 1;
+}
+
+/* Lista CSR de uma FD: atributos crescentes abaixo de limit, exatamente
+   os do conjunto */
+static int attrListMatches(const int *attrs, int begin, int end, attrset set, int limit)
+{
+  for (int k = begin; k < end; ++k)
+    if (attrs[k] < 0 || attrs[k] >= limit || (k > begin && attrs[k] <= attrs[k - 1]) ||
+        !attrsetHas(set, attrs[k]))
+      return 0;
+  return end - begin == attrsetCount(set);
+}
+
+/* O fecho indexa os vetores pelo que está gravado: tudo precisa estar no
+   intervalo e coerente entre si antes de ser usado */
+static int closureIndexValid(const ClosureIndex *shape, int schemaAttrCount)
+{
+  int n = shape->fdCount;
+  if (shape->attrCount > shape->fdAttrCount || shape->fdAttrCount > schemaAttrCount ||
+      !setsWithin(shape->lhs, (uint64_t)n, shape->attrCount) ||
+      !setsWithin(shape->rhs, (uint64_t)n, shape->fdAttrCount))
+    return 0;
+
+  if (!startsValid(shape->listStart, shape->attrCount, shape->listStart[shape->attrCount]) ||
+      !startsValid(shape->fdLhsStart, n, shape->fdLhsStart[n]) ||
+      !startsValid(shape->fdRhsStart, n, shape->fdRhsStart[n]) ||
+      shape->listStart[shape->attrCount] != shape->fdLhsStart[n])
+    return 0;
+
+  for (int i = 0; i < n; ++i)
+  {
+    if (shape->lhsSize[i] != shape->fdLhsStart[i + 1] - shape->fdLhsStart[i] ||
+        !attrListMatches(shape->fdLhsAttrs, shape->fdLhsStart[i], shape->fdLhsStart[i + 1], shape->lhs[i],
+                         shape->attrCount) ||
+        !attrListMatches(shape->fdRhsAttrs, shape->fdRhsStart[i], shape->fdRhsStart[i + 1], shape->rhs[i],
+                         shape->fdAttrCount))
+      return 0;
+  }
+
+  for (int a = 0; a < shape->attrCount; ++a)
+  {
+    for (int k = shape->listStart[a]; k < shape->listStart[a + 1]; ++k)
+    {
+      int fd = shape->listFds[k];
+      if (fd < 0 || fd >= n || !attrsetHas(shape->lhs[fd], a))
+        return 0;
+    }
+  }
+
+  for (int k = 0; k < shape->emptyLhsCount; ++k)
+  {
+    int fd = shape->emptyLhsFds[k];
+    if (fd < 0 || fd >= n || shape->lhsSize[fd] != 0)
+      return 0;
+  }
+
+  return 1;
+}
+
+static int loadClosureIndex(FdSchema *schema, const FdbHeader *header)
+{
+  ClosureIndex shape;
+  memset(&shape, 0, sizeof(ClosureIndex));
+
+  if (header->indexFdCount < 0 || header->indexAttrCount < 0 || header->indexFdAttrCount < 0 ||
+      header->indexEmptyLhsCount < 0 || header->indexAttrCount > ATTRSET_MAX_ATTRS)
+    return -1;
+
+  uint64_t n = (uint64_t)header->indexFdCount;
+  shape.fdCount = header->indexFdCount;
+  shape.attrCount = header->indexAttrCount;
+  shape.fdAttrCount = header->indexFdAttrCount;
+  shape.emptyLhsCount = header->indexEmptyLhsCount;
+
+  shape.lhs = sectionData(schema, header, FDB_INDEX_LHS, sizeof(attrset), n);
+  shape.rhs = sectionData(schema, header, FDB_INDEX_RHS, sizeof(attrset), n);
+  shape.lhsSize = sectionData(schema, header, FDB_INDEX_LHS_SIZE, sizeof(int), n);
+  shape.listStart = sectionData(schema, header, FDB_INDEX_LIST_START, sizeof(int), (uint64_t)shape.attrCount + 1);
+  shape.emptyLhsFds = sectionData(schema, header, FDB_INDEX_EMPTY_LHS, sizeof(int), (uint64_t)shape.emptyLhsCount);
+  shape.fdLhsStart = sectionData(schema, header, FDB_INDEX_FD_LHS_START, sizeof(int), n + 1);
+  shape.fdRhsStart = sectionData(schema, header, FDB_INDEX_FD_RHS_START, sizeof(int), n + 1);
+  if (!shape.lhs || !shape.rhs || !shape.lhsSize || !shape.listStart || !shape.emptyLhsFds ||
+      !shape.fdLhsStart || !shape.fdRhsStart)
+    return -1;
+
+  /* Tamanhos das listas vêm dos vetores de início */
+  int listTotal = shape.listStart[shape.attrCount];
+  int lhsTotal = shape.fdLhsStart[n];
+  int rhsTotal = shape.fdRhsStart[n];
+  if (listTotal < 0 || lhsTotal < 0 || rhsTotal < 0)
+    return -1;
+
+  shape.listFds = sectionData(schema, header, FDB_INDEX_LIST_FDS, sizeof(int), (uint64_t)listTotal);
+  shape.fdLhsAttrs = sectionData(schema, header, FDB_INDEX_FD_LHS_ATTRS, sizeof(int), (uint64_t)lhsTotal);
+  shape.fdRhsAttrs = sectionData(schema, header, FDB_INDEX_FD_RHS_ATTRS, sizeof(int), (uint64_t)rhsTotal);
+  if (!shape.listFds || !shape.fdLhsAttrs || !shape.fdRhsAttrs ||
+      !closureIndexValid(&shape, (int)header->attrCount))
+    return -1;
+
+  schema->closureIndex = wrapClosureIndex(&shape);
+  return schema->closureIndex ? 0 : -1;
+}
+
+static int loadFdbFile(const char *path, AttrDict *dict, FdSchema *schema)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    fprintf(stderr, "Error: cannot read %s\n", path);
+    return -1;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(FdbHeader))
+  {
+    close(fd);
+    fprintf(stderr, "Error: %s: truncated compiled file\n", path);
+    return -1;
+  }
+
+  /* Privado e gravável: escritas no índice ficam na cópia da página */
+  void *data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    fprintf(stderr, "Error: cannot map %s\n", path);
+    return -1;
+  }
+
+  schema->mapping = data;
+  schema->mappingSize = (size_t)info.st_size;
+
+  const FdbHeader *header = data;
+  if (header->byteOrder != FDB_BYTE_ORDER)
+  {
+    fprintf(stderr, "Error: %s: written on a machine with another byte order\n", path);
+    return -1;
+  }
+  if (header->formatVersion != FDB_FORMAT_VERSION)
+  {
+    fprintf(stderr, "Error: %s: format version %u, expected %d; compile it again\n", path,
+            header->formatVersion, FDB_FORMAT_VERSION);
+    return -1;
+  }
+  if (header->setWords != ATTRSET_MAX_WORDS)
+  {
+    fprintf(stderr, "Error: %s: written with ATTR_WORDS=%u, this build uses %d; compile it again\n", path,
+            header->setWords, ATTRSET_MAX_WORDS);
+    return -1;
+  }
+
+  int valid = header->attrCount <= ATTRSET_MAX_ATTRS && header->fdCount >= 0 && header->coverCount >= 0 &&
+              header->keyCount >= 0 && loadNames(schema, header, dict) == 0;
+
+  attrset *universe = valid ? sectionData(schema, header, FDB_UNIVERSE, sizeof(attrset), 1) : NULL;
+  schema->fds = valid ? sectionData(schema, header, FDB_FDS, sizeof(FD), (uint64_t)header->fdCount) : NULL;
+  schema->fdCount = header->fdCount;
+  valid = valid && universe && schema->fds && setsWithin(universe, 1, (int)header->attrCount) &&
+          fdsWithin(schema->fds, (uint64_t)header->fdCount, (int)header->attrCount);
+  if (valid)
+    schema->U = *universe;
+
+  if (valid && (header->flags & FDB_HAS_COVER))
+  {
+    schema->cover = sectionData(schema, header, FDB_COVER, sizeof(FD), (uint64_t)header->coverCount);
+    schema->coverCount = header->coverCount;
+    valid = schema->cover && fdsWithin(schema->cover, (uint64_t)header->coverCount, (int)header->attrCount);
+  }
+
+  if (valid && (header->flags & FDB_HAS_KEYS))
+  {
+    schema->keys = sectionData(schema, header, FDB_KEYS, sizeof(attrset), (uint64_t)header->keyCount);
+    schema->keyCount = header->keyCount;
+    valid = schema->keys && setsWithin(schema->keys, (uint64_t)header->keyCount, (int)header->attrCount);
+  }
+
+  if (valid && (header->flags & FDB_HAS_INDEX))
+    valid = schema->cover && loadClosureIndex(schema, header) == 0;
+
+  if (!valid)
+  {
+    fprintf(stderr, "Error: %s: corrupt compiled file\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+/* Só o bloco pedido é lido e dict começa vazio: os índices dos nomes
+   em dict já são os locais, sem passar por um Catalog */
+static int takeRelation(void *context, const char *name, size_t nameLength, int *attributes, int attributeCount,
+                        attrset U, FD *fds, int fdCount)
+{
+  (void)name;
+  (void)nameLength;
+  (void)attributeCount;
+  FdSchema *schema = context;
+
+  free(attributes);
+  schema->fds = fds;
+  schema->fdCount = fdCount;
+  schema->U = U;
+  return 0;
+}
+
+static int loadCatalogRelation(const char *path, const char *relation, AttrDict *dict, FdSchema *schema)
+{
+  if (!relation)
+  {
+    fprintf(stderr, "Error: %s is a catalog: a relation name is required\n", path);
+    return -1;
+  }
+  if (!isCatalogFile(path))
+  {
+    fprintf(stderr, "Error: %s is not a catalog\n", path);
+    return -1;
+  }
+
+  return parseFdsCatalogFile(path, relation, dict, takeRelation, schema);
+}
+
+int loadSchema(const char *path, AttrDict *dict, FdSchema *schema)
+{
+  return loadSchemaRelation(path, NULL, dict, schema);
+}
+
+int loadSchemaRelation(const char *path, const char *relation, AttrDict *dict, FdSchema *schema)
+{
+  memset(schema, 0, sizeof(FdSchema));
+  STATS_PHASE_BEGIN(timer);
+
+  int status = 0;
+  if (relation || isCatalogFile(path))
+    status = loadCatalogRelation(path, relation, dict, schema);
+  else if (isFdbFile(path))
+  {
+    status = loadFdbFile(path, dict, schema);
+    if (status != 0)
+      freeSchema(schema);
+  }
+  else
+  {
+    schema->fds = parseFdsFile(path, dict, &schema->U, &schema->fdCount);
+    status = schema->fds ? 0 : -1;
+  }
+
+  STATS_PHASE_END(STAT_PHASE_LOAD, timer);
+  return status;
+}
+
+void freeSchema(FdSchema *schema)
+{
+  freeClosureIndex(schema->closureIndex);
+
+  if (schema->mapping)
+    munmap(schema->mapping, schema->mappingSize);
+  else
+    free(schema->fds);
+
+  memset(schema, 0, sizeof(FdSchema));
+}
@@ -0,0 +1,77 @@
+#ifndef FDB_H
+#define FDB_H
+
+#include <stddef.h>
+#include "attrset.h"
+#include "parser.h"
+#include "closure.h"
+
+/* -----------------------------------------------------------------------------
+   Formato binário compilado (.fdb) de um conjunto de DFs.
+
+   Um cabeçalho fixo seguido de seções alinhadas a 64 bytes, cada uma um
+   vetor no layout de memória do programa:
+       nomes dos atributos (terminados em '\0', na ordem dos índices),
+       U, FDs de entrada,
+       e, opcionais: cobertura mínima, chaves candidatas e o índice de
+       fecho mesclado (vetores do ClosureIndex) sobre a cobertura.
+
+   O arquivo é mapeado com mmap (MAP_PRIVATE) e FDs, cobertura, chaves e
+   índice são usados no lugar, sem cópia nem nova análise; escritas, como
+   removeClosureIndexFd, só tocam a cópia privada da página. Só o
+   dicionário de nomes é reconstruído (no máximo ATTRSET_MAX_ATTRS nomes).
+
+   O cabeçalho guarda a versão do formato, a ordem dos bytes e
+   ATTRSET_MAX_WORDS de quem gravou; um arquivo de outra versão, ordem ou
+   largura é recusado (basta compilá-lo de novo a partir do .fds).
+
+   Antes de qualquer uso, as seções são conferidas contra o tamanho do
+   arquivo e o conteúdo contra o cabeçalho: U, FDs, cobertura e chaves só
+   com atributos abaixo do número de nomes, e o índice de fecho coerente
+   (vetores de início CSR crescentes, listas iguais aos conjuntos, FDs e
+   atributos dentro do intervalo), de modo que um arquivo corrompido é
+   recusado em vez de ler fora dos vetores. O que não é conferido é o
+   significado: uma cobertura ou chaves gravadas erradas, mas bem
+   formadas, são usadas como estão.
+ ----------------------------------------------------------------------------- */
+#define FDB_FORMAT_VERSION 1
+
+/* Esquema carregado de um .fds (texto) ou de um .fdb (binário).
+   Os campos opcionais são NULL quando não estão disponíveis. */
+typedef struct
+{
+  attrset U;
+  FD *fds;
+  int fdCount;
+
+  FD *cover;
+  int coverCount;
+
+  attrset *keys;
+  int keyCount;
+
+  ClosureIndex *closureIndex; // mesclado, sobre cover
+
+  void *mapping; // .fdb mapeado (NULL para .fds)
+  size_t mappingSize;
+} FdSchema;
+
+// 1 se path é um arquivo regular que começa com a assinatura de .fdb
+int isFdbFile(const char *path);
+
+/* Lê path, em qualquer dos dois formatos (decidido pela assinatura, não
+   pela extensão). dict deve estar vazio. 0 ou -1 com erro em stderr. */
+int loadSchema(const char *path, AttrDict *dict, FdSchema *schema);
+
+/* O mesmo, aceitando também um catálogo (catalog.h): relation escolhe a
+   relação, e é obrigatória para catálogos (NULL = loadSchema). */
+int loadSchemaRelation(const char *path, const char *relation, AttrDict *dict, FdSchema *schema);
+void freeSchema(FdSchema *schema);
+
+/* Grava o esquema em path: o que for NULL em cover, keys e closureIndex fica
+   fora do arquivo. O índice só é gravado junto com a cobertura. Grava num
+   arquivo temporário e o renomeia, então path nunca fica pela metade.
+   0 ou -1 com erro em stderr. */
+int writeFdbFile(const char *path, const AttrDict *dict, const FdSchema *schema);
+
+#endif
@@ -0,0 +1,214 @@
+#include "fdtable.h"
+#include "stats.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compareFdsByLhs(const void *a, const void *b)
+{
+  return attrsetCompare(((const FD *)a)->lhs, ((const FD *)b)->lhs);
+}
+
+/* -----------------------------------------------------------------------------
+   Construção: ordena por LHS, junta LHS iguais e monta os planos
+ ----------------------------------------------------------------------------- */
+typedef void (*ChunkScan)(const FdTable *, size_t, const uint64_t *, uint64_t *);
+static ChunkScan chunkScan = NULL;
+
+/* Escolhida uma vez: tabelas são montadas em paralelo (serve, batch,
+   libfdtool) */
+static pthread_once_t chunkScanOnce = PTHREAD_ONCE_INIT;
+static void selectChunkScan(void);
+
+FdTable *buildFdTable(const FD *fds, int fdCount)
+{
+  pthread_once(&chunkScanOnce, selectChunkScan);
+
+  Arena *scratch = getScratchArena();
+  FdTable *table = calloc(1, sizeof(FdTable));
+  FD *sorted = scratchAlloc(scratch, sizeof(FD) * (fdCount > 0 ? fdCount : 1));
+  if (!table || !sorted)
+  {
+    free(table);
+    scratchFree(scratch, sorted);
+    return NULL;
+  }
+
+  memcpy(sorted, fds, sizeof(FD) * fdCount);
+  qsort(sorted, fdCount, sizeof(FD), compareFdsByLhs);
+
+  /* Junta FDs de mesmo LHS e tira do RHS o que já está no LHS */
+  int count = 0;
+  for (int i = 0; i < fdCount; ++i)
+  {
+    attrset rhs = attrsetMinus(sorted[i].rhs, sorted[i].lhs);
+
+    if (count > 0 && attrsetEquals(sorted[count - 1].lhs, sorted[i].lhs))
+    {
+      sorted[count - 1].rhs = attrsetUnion(sorted[count - 1].rhs, rhs);
+      continue;
+    }
+
+    sorted[count].lhs = sorted[i].lhs;
+    sorted[count].rhs = rhs;
+    count++;
+  }
+
+  /* FDs triviais não acrescentam nada ao fecho */
+  int kept = 0;
+  for (int i = 0; i < count; ++i)
+    if (!attrsetIsEmpty(sorted[i].rhs))
+      sorted[kept++] = sorted[i];
+  count = kept;
+
+  table->count = count;
+  table->words = activeAttrsetWords();
+  table->stride = ((size_t)count + FDTABLE_CHUNK - 1) / FDTABLE_CHUNK * FDTABLE_CHUNK;
+  if (table->stride == 0)
+    table->stride = FDTABLE_CHUNK;
+
+  table->maxLhsSize = count > 0 ? attrsetCount(sorted[count - 1].lhs) : 0;
+
+  size_t planeBytes = sizeof(uint64_t) * table->stride * table->words;
+  table->lhsPlanes = aligned_alloc(64, planeBytes);
+  table->lhs = malloc(sizeof(attrset) * (count > 0 ? count : 1));
+  table->rhs = malloc(sizeof(attrset) * (count > 0 ? count : 1));
+  table->bucketStart = calloc(table->maxLhsSize + 2, sizeof(int));
+
+  if (!table->lhsPlanes || !table->lhs || !table->rhs || !table->bucketStart)
+  {
+    scratchFree(scratch, sorted);
+    freeFdTable(table);
+    return NULL;
+  }
+
+  /* Planos por palavra; posições de preenchimento ficam zeradas */
+  memset(table->lhsPlanes, 0, planeBytes);
+  for (int i = 0; i < count; ++i)
+  {
+    table->lhs[i] = sorted[i].lhs;
+    table->rhs[i] = sorted[i].rhs;
+    for (int w = 0; w < table->words; ++w)
+      table->lhsPlanes[(size_t)w * table->stride + i] = sorted[i].lhs.w[w];
+
+    table->bucketStart[attrsetCount(sorted[i].lhs) + 1]++;
+  }
+
+  for (int k = 0; k <= table->maxLhsSize; ++k)
+    table->bucketStart[k + 1] += table->bucketStart[k];
+
+  scratchFree(scratch, sorted);
+  return table;
+}
+
+void freeFdTable(FdTable *table)
+{
+  if (!table)
+    return;
+
+  free(table->lhsPlanes);
+  free(table->lhs);
+  free(table->rhs);
+  free(table->bucketStart);
+  free(table);
+}
+
+FD *fdTableToFds(const FdTable *table)
+{
+  FD *fds = malloc(sizeof(FD) * (table->count > 0 ? table->count : 1));
+  if (!fds)
+    return NULL;
+
+  for (int i = 0; i < table->count; ++i)
+  {
+    fds[i].lhs = table->lhs[i];
+    fds[i].rhs = table->rhs[i];
+  }
+  return fds;
+}
+
+/* -----------------------------------------------------------------------------
+   Teste de contenção de um bloco de FDTABLE_CHUNK FDs:
+   miss[k] = 0 sse o LHS da FD begin + k está contido no fecho.
+   O laço interno tem tamanho fixo e acesso contíguo, e é vetorizado pelo
+   compilador; a versão AVX2 é escolhida em tempo de execução.
+ ----------------------------------------------------------------------------- */
+static inline __attribute__((always_inline)) void chunkMisses(const FdTable *table, size_t begin,
+                                                              const uint64_t *closureWords, uint64_t *miss)
+{
+  for (int k = 0; k < FDTABLE_CHUNK; ++k)
+    miss[k] = 0;
+
+  for (int w = 0; w < table->words; ++w)
+  {
+    const uint64_t *plane = __builtin_assume_aligned(table->lhsPlanes + (size_t)w * table->stride + begin, 64);
+    uint64_t outside = ~closureWords[w];
+
+    for (int k = 0; k < FDTABLE_CHUNK; ++k)
+      miss[k] |= plane[k] & outside;
+  }
+}
+
+static void chunkMissesGeneric(const FdTable *table, size_t begin, const uint64_t *closureWords, uint64_t *miss)
+{
+  chunkMisses(table, begin, closureWords, miss);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void chunkMissesAvx2(const FdTable *table, size_t begin,
+                                                            const uint64_t *closureWords, uint64_t *miss)
+{
+  chunkMisses(table, begin, closureWords, miss);
+}
+#endif
+
+static void selectChunkScan(void)
+{
+  chunkScan = chunkMissesGeneric;
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    chunkScan = chunkMissesAvx2;
+#endif
+}
+
+attrset fdTableClosure(const FdTable *table, attrset X)
+{
+  attrset closure = X;
+  int changed = 1;
+  int passes = 0;
+
+  while (changed)
+  {
+    changed = 0;
+    passes++;
+
+    /* Só os baldes com |LHS| <= |fecho| podem disparar */
+    int size = attrsetCount(closure);
+    int limit = table->bucketStart[(size < table->maxLhsSize ? size : table->maxLhsSize) + 1];
+
+    for (int begin = 0; begin < limit; begin += FDTABLE_CHUNK)
+    {
+      uint64_t miss[FDTABLE_CHUNK];
+      chunkScan(table, (size_t)begin, closure.w, miss);
+
+      int end = limit - begin < FDTABLE_CHUNK ? limit - begin : FDTABLE_CHUNK;
+      for (int k = 0; k < end; ++k)
+      {
+        if (miss[k])
+          continue;
+
+        attrset missing = attrsetMinus(table->rhs[begin + k], closure);
+        if (!attrsetIsEmpty(missing))
+        {
+          closure = attrsetUnion(closure, missing);
+          changed = 1;
+        }
+      }
+    }
+  }
+
+  STATS_COUNT(STAT_FIXPOINT_ITERATIONS, passes);
+  return closure;
+}
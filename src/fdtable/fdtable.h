@@ -0,0 +1,50 @@
+#ifndef FDTABLE_H
+#define FDTABLE_H
+
+#include <stdint.h>
+#include "parser.h"
+
+/* FDs testadas por vez no teste de contenção vetorizado */
+#define FDTABLE_CHUNK 64
+
+/* -----------------------------------------------------------------------------
+   Tabela de FDs em formato de estrutura de arrays.
+
+   Na construção, FDs com o mesmo LHS (inclusive duplicadas) viram uma só,
+   com a união dos RHS; atributos do RHS que já estão no LHS são descartados
+   e FDs triviais somem. O conjunto resultante é equivalente ao original.
+
+   As FDs ficam ordenadas por |LHS| (ordem canônica de attrsetCompare), em
+   baldes: as de |LHS| = k estão em [bucketStart[k], bucketStart[k + 1]).
+   Uma FD com |LHS| > |fecho| não pode disparar, então uma varredura só
+   precisa ir até o balde do tamanho atual do fecho.
+
+   Os LHS ficam em planos por palavra, alinhados a 64 bytes:
+   lhsPlanes[w * stride + i] é a palavra w do LHS da FD i. Assim o teste
+   LHS ⊆ fecho de um bloco de FDs é um laço contíguo por palavra, que vira
+   instruções SIMD (4 FDs por instrução com AVX2).
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  int count;
+  int words;      // palavras ativas na construção
+  size_t stride;  // count arredondado para múltiplo de FDTABLE_CHUNK
+
+  uint64_t *lhsPlanes;
+  attrset *lhs;
+  attrset *rhs;
+
+  int maxLhsSize;
+  int *bucketStart; // maxLhsSize + 2 posições
+} FdTable;
+
+FdTable *buildFdTable(const FD *fds, int fdCount);
+void freeFdTable(FdTable *table);
+
+// Cópia das FDs da tabela, na ordem dela (para quem consome FD *)
+FD *fdTableToFds(const FdTable *table);
+
+// X+ por varreduras da tabela até não haver mudança
+attrset fdTableClosure(const FdTable *table, attrset X);
+
+#endif
@@ -0,0 +1,368 @@
+#include "fdtool.h"
+#include "analysis.h"
+#include "arena.h"
+#include "fdb.h"
+#include "keyindex.h"
+#include "normalform.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct FdContext
+{
+  int loaded;
+  AttrDict dict;
+  FdSchema schema;
+  AnalysisContext analysis;
+
+  // Índice de superchaves, montado na primeira consulta
+  int haveKeyIndex;
+  KeyIndex keyIndex;
+
+  Arena scratch;
+};
+
+/* ---------------------------------------------------------------
+   Rascunho de cada chamada: a arena do contexto e a largura de
+   conjuntos do seu esquema (1 antes da carga, que a alarga) ficam
+   instaladas durante a chamada; no fim a arena é descartada e a
+   thread volta ao que tinha
+---------------------------------------------------------------- */
+typedef struct
+{
+  Arena *arena;
+  int attrWords;
+} CallState;
+
+static int schemaWords(const FdContext *ctx)
+{
+  return ctx->loaded ? ctx->analysis.attrWords : 1;
+}
+
+static CallState beginCall(FdContext *ctx)
+{
+  CallState previous = {setScratchArena(&ctx->scratch), activeAttrsetWords()};
+  attrsetUseWords(schemaWords(ctx));
+  return previous;
+}
+
+static void endCall(FdContext *ctx, CallState previous)
+{
+  arenaReset(&ctx->scratch);
+  setScratchArena(previous.arena);
+  attrsetUseWords(previous.attrWords);
+}
+
+FdContext *createFdContext(size_t arenaBlockSize)
+{
+  FdContext *ctx = calloc(1, sizeof(FdContext));
+  if (!ctx)
+    return NULL;
+
+  initAttrDict(&ctx->dict);
+  initArena(&ctx->scratch, arenaBlockSize);
+  return ctx;
+}
+
+static void unloadSchema(FdContext *ctx)
+{
+  if (ctx->haveKeyIndex)
+    freeKeyIndex(&ctx->keyIndex);
+  if (ctx->loaded)
+  {
+    freeAnalysisContext(&ctx->analysis);
+    freeSchema(&ctx->schema);
+  }
+  freeAttrDict(&ctx->dict);
+
+  ctx->haveKeyIndex = 0;
+  ctx->loaded = 0;
+}
+
+void freeFdContext(FdContext *ctx)
+{
+  if (!ctx)
+    return;
+
+  unloadSchema(ctx);
+  freeArena(&ctx->scratch);
+  free(ctx);
+}
+
+static int requireSchema(const FdContext *ctx)
+{
+  if (ctx->loaded)
+    return 0;
+  fprintf(stderr, "Error: no schema loaded\n");
+  return -1;
+}
+
+static int requireAnalysis(FdContext *ctx)
+{
+  if (!analysisFailed(&ctx->analysis))
+    return 0;
+  fprintf(stderr, "Error: out of memory\n");
+  return -1;
+}
+
+/* ---------------------------------------------------------------
+   Carga
+---------------------------------------------------------------- */
+static void attachSchema(FdContext *ctx)
+{
+  FdSchema *schema = &ctx->schema;
+  initAnalysisContext(&ctx->analysis, schema->U, schema->fds, schema->fdCount);
+  analysisUsePrecomputed(&ctx->analysis, schema->cover, schema->coverCount, schema->closureIndex,
+                         schema->keys, schema->keyCount);
+  ctx->loaded = 1;
+}
+
+int fdLoadFile(FdContext *ctx, const char *path)
+{
+  return fdLoadRelation(ctx, path, NULL);
+}
+
+int fdLoadRelation(FdContext *ctx, const char *path, const char *relation)
+{
+  unloadSchema(ctx);
+
+  CallState previous = beginCall(ctx);
+  int status = loadSchemaRelation(path, relation, &ctx->dict, &ctx->schema);
+  if (status == 0)
+    attachSchema(ctx);
+  else
+    freeAttrDict(&ctx->dict);
+  endCall(ctx, previous);
+  return status;
+}
+
+int fdLoadText(FdContext *ctx, const char *text, size_t length)
+{
+  unloadSchema(ctx);
+
+  CallState previous = beginCall(ctx);
+  memset(&ctx->schema, 0, sizeof(FdSchema));
+  ctx->schema.fds = parseFdsText("<text>", text, length, &ctx->dict, &ctx->schema.U, &ctx->schema.fdCount);
+  int status = ctx->schema.fds ? 0 : -1;
+  if (status == 0)
+    attachSchema(ctx);
+  else
+    freeAttrDict(&ctx->dict);
+  endCall(ctx, previous);
+  return status;
+}
+
+/* ---------------------------------------------------------------
+   Atributos
+---------------------------------------------------------------- */
+int fdAttributeCount(const FdContext *ctx)
+{
+  return ctx->dict.count;
+}
+
+const char *fdAttributeName(const FdContext *ctx, int attr)
+{
+  if (attr < 0 || attr >= ctx->dict.count)
+    return NULL;
+  return ctx->dict.names[attr];
+}
+
+int fdFindAttribute(const FdContext *ctx, const char *name)
+{
+  return findAttribute(&ctx->dict, name, strlen(name));
+}
+
+static int attrsetToIndexes(attrset set, int *out)
+{
+  int count = 0;
+  for (int a = attrsetNext(set, 0); a >= 0; a = attrsetNext(set, a + 1))
+    out[count++] = a;
+  return count;
+}
+
+int fdParseAttributes(const FdContext *ctx, const char *names, int *out)
+{
+  int previous = activeAttrsetWords();
+  attrsetUseWords(schemaWords(ctx));
+
+  attrset X;
+  int result = -1;
+  if (attrsetFromKnownNames(&ctx->dict, names, &X) != 0)
+    fprintf(stderr, "Error: unknown attributes in %s\n", names);
+  else
+    result = attrsetToIndexes(X, out);
+
+  attrsetUseWords(previous);
+  return result;
+}
+
+static int indexesToAttrset(const FdContext *ctx, const int *attrs, int count, attrset *out)
+{
+  *out = attrsetEmpty();
+  for (int i = 0; i < count; ++i)
+  {
+    if (attrs[i] < 0 || attrs[i] >= ctx->dict.count)
+    {
+      fprintf(stderr, "Error: invalid attribute index %d\n", attrs[i]);
+      return -1;
+    }
+    attrsetInsert(out, attrs[i]);
+  }
+  return 0;
+}
+
+/* ---------------------------------------------------------------
+   Consultas
+---------------------------------------------------------------- */
+int fdClosure(FdContext *ctx, const int *attrs, int count, int *out)
+{
+  attrset X;
+  if (requireSchema(ctx) != 0 || indexesToAttrset(ctx, attrs, count, &X) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  ClosureIndex *index = analysisCoverIndex(&ctx->analysis);
+  int result = -1;
+  if (index && requireAnalysis(ctx) == 0)
+    result = attrsetToIndexes(computeClosureIndexed(index, X), out);
+  endCall(ctx, previous);
+  return result;
+}
+
+static int ensureKeyIndex(FdContext *ctx)
+{
+  if (ctx->haveKeyIndex)
+    return 0;
+
+  int keyCount = 0;
+  const attrset *keys = analysisKeys(&ctx->analysis, &keyCount);
+  if (requireAnalysis(ctx) != 0)
+    return -1;
+
+  int failed = initKeyIndex(&ctx->keyIndex) != 0;
+  if (failed)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+  for (int i = 0; i < keyCount && !failed; ++i)
+    failed = keyIndexInsert(&ctx->keyIndex, keys[i]) != 0;
+  if (failed)
+  {
+    freeKeyIndex(&ctx->keyIndex);
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+
+  ctx->haveKeyIndex = 1;
+  return 0;
+}
+
+int fdSuperkey(FdContext *ctx, const int *attrs, int count, int *keyOut, int *keyCount)
+{
+  attrset X, key;
+  if (requireSchema(ctx) != 0 || indexesToAttrset(ctx, attrs, count, &X) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  int result = -1;
+  if (ensureKeyIndex(ctx) == 0)
+  {
+    result = keyIndexFindSubset(&ctx->keyIndex, X, &key);
+    if (result && keyOut)
+    {
+      int size = attrsetToIndexes(key, keyOut);
+      if (keyCount)
+        *keyCount = size;
+    }
+  }
+  endCall(ctx, previous);
+  return result;
+}
+
+int fdCoverCount(FdContext *ctx)
+{
+  if (requireSchema(ctx) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  int coverCount = 0;
+  analysisCover(&ctx->analysis, &coverCount);
+  int result = requireAnalysis(ctx) == 0 ? coverCount : -1;
+  endCall(ctx, previous);
+  return result;
+}
+
+int fdCoverFd(FdContext *ctx, int i, int *lhs, int *lhsCount, int *rhs, int *rhsCount)
+{
+  int coverCount = fdCoverCount(ctx);
+  if (coverCount < 0)
+    return -1;
+  if (i < 0 || i >= coverCount)
+  {
+    fprintf(stderr, "Error: invalid dependency index %d\n", i);
+    return -1;
+  }
+
+  CallState previous = beginCall(ctx);
+  const FD *cover = analysisCover(&ctx->analysis, &coverCount);
+  *lhsCount = attrsetToIndexes(cover[i].lhs, lhs);
+  *rhsCount = attrsetToIndexes(cover[i].rhs, rhs);
+  endCall(ctx, previous);
+  return 0;
+}
+
+int fdKeyCount(FdContext *ctx)
+{
+  if (requireSchema(ctx) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  int keyCount = 0;
+  analysisKeys(&ctx->analysis, &keyCount);
+  int result = requireAnalysis(ctx) == 0 ? keyCount : -1;
+  endCall(ctx, previous);
+  return result;
+}
+
+int fdKey(FdContext *ctx, int i, int *out)
+{
+  int keyCount = fdKeyCount(ctx);
+  if (keyCount < 0)
+    return -1;
+  if (i < 0 || i >= keyCount)
+  {
+    fprintf(stderr, "Error: invalid key index %d\n", i);
+    return -1;
+  }
+
+  CallState previous = beginCall(ctx);
+  const attrset *keys = analysisKeys(&ctx->analysis, &keyCount);
+  int size = attrsetToIndexes(keys[i], out);
+  endCall(ctx, previous);
+  return size;
+}
+
+int fdNormalForms(FdContext *ctx, int *bcnfViolations, int *nf3Violations)
+{
+  if (requireSchema(ctx) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  int result = countNormalFormViolations(&ctx->analysis, bcnfViolations, nf3Violations);
+  if (result != 0)
+    fprintf(stderr, "Error: out of memory\n");
+  endCall(ctx, previous);
+  return result;
+}
+
+int fdPrintNormalForms(FdContext *ctx, FILE *out)
+{
+  if (requireSchema(ctx) != 0)
+    return -1;
+
+  CallState previous = beginCall(ctx);
+  fprintNormalForms(out, &ctx->dict, &ctx->analysis);
+  int result = analysisFailed(&ctx->analysis) ? -1 : 0;
+  endCall(ctx, previous);
+  return result;
+}
@@ -0,0 +1,85 @@
+#ifndef FDTOOL_H
+#define FDTOOL_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* -----------------------------------------------------------------------------
+   libfdtool: a análise de dependências funcionais sem a linha de comando
+   (make lib gera libfdtool.a e libfdtool.so; só este cabeçalho é público).
+
+   Tudo passa por um FdContext, que guarda um esquema carregado, os
+   resultados já calculados sobre ele (cobertura, índice de fecho, chaves)
+   e uma arena de rascunho. Os vetores temporários de cada chamada (filas,
+   conjuntos visitados, máscaras, tabelas de veredictos) vêm da arena, que
+   é descartada em O(1) ao fim da chamada e reaproveitada na próxima: depois
+   que os resultados do esquema foram calculados e a arena chegou ao pico,
+   as consultas não chamam mais o malloc.
+
+   Atributos são índices de 0 a fdAttributeCount() - 1; conjuntos de
+   atributos são vetores de índices em ordem crescente. Vetores de saída
+   precisam de espaço para fdAttributeCount() índices.
+
+   Um contexto só pode ser usado por uma thread de cada vez; contextos
+   diferentes podem ser usados em paralelo. Erros retornam -1 (ou NULL),
+   com a mensagem em stderr, como na linha de comando.
+ ----------------------------------------------------------------------------- */
+typedef struct FdContext FdContext;
+
+/* libfdtool.so é compilada com -fvisibility=hidden: só o que é marcado
+   aqui é exportado */
+#if defined(__GNUC__)
+#define FDTOOL_API __attribute__((visibility("default")))
+#else
+#define FDTOOL_API
+#endif
+
+/* arenaBlockSize: tamanho dos blocos da arena (0 = 1 MiB). NULL sem
+   memória. */
+FDTOOL_API FdContext *createFdContext(size_t arenaBlockSize);
+FDTOOL_API void freeFdContext(FdContext *ctx);
+
+/* Carrega um esquema (.fds ou .fdb) no lugar do anterior. 0 ou -1; com
+   erro o contexto fica vazio. */
+FDTOOL_API int fdLoadFile(FdContext *ctx, const char *path);
+/* A relação de nome relation de um catálogo (.fdc), lida sem passar pelas
+   outras; com relation NULL, o mesmo que fdLoadFile */
+FDTOOL_API int fdLoadRelation(FdContext *ctx, const char *path, const char *relation);
+// O mesmo para um texto .fds em memória
+FDTOOL_API int fdLoadText(FdContext *ctx, const char *text, size_t length);
+
+/* ---- Atributos ---- */
+FDTOOL_API int fdAttributeCount(const FdContext *ctx);
+FDTOOL_API const char *fdAttributeName(const FdContext *ctx, int attr);
+// Índice do atributo, ou -1 se não existe
+FDTOOL_API int fdFindAttribute(const FdContext *ctx, const char *name);
+/* Nomes separados por espaço (ou concatenados, como na linha de comando)
+   em índices. Quantidade de atributos, ou -1 se algum nome não existe. */
+FDTOOL_API int fdParseAttributes(const FdContext *ctx, const char *names, int *out);
+
+/* ---- Consultas ---- */
+
+// X+ em out; retorna o tamanho do fecho, ou -1
+FDTOOL_API int fdClosure(FdContext *ctx, const int *attrs, int count, int *out);
+
+/* 1 se X é superchave (com keyOut != NULL, recebe uma chave candidata
+   contida em X, e *keyCount o seu tamanho), 0 se não é, -1 com erro */
+FDTOOL_API int fdSuperkey(FdContext *ctx, const int *attrs, int count, int *keyOut, int *keyCount);
+
+// Cobertura mínima: quantidade de DFs, ou -1
+FDTOOL_API int fdCoverCount(FdContext *ctx);
+// DF i da cobertura em lhs e rhs; 0 ou -1
+FDTOOL_API int fdCoverFd(FdContext *ctx, int i, int *lhs, int *lhsCount, int *rhs, int *rhsCount);
+
+// Chaves candidatas: quantidade, ou -1
+FDTOOL_API int fdKeyCount(FdContext *ctx);
+// Chave i em out; retorna o seu tamanho, ou -1
+FDTOOL_API int fdKey(FdContext *ctx, int i, int *out);
+
+/* Violações de BCNF e 3NF na cobertura mínima (0 = na forma normal).
+   0 ou -1. */
+FDTOOL_API int fdNormalForms(FdContext *ctx, int *bcnfViolations, int *nf3Violations);
+// O relatório de fdtool normalform
+FDTOOL_API int fdPrintNormalForms(FdContext *ctx, FILE *out);
+
+#endif
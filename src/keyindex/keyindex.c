@@ -0,0 +1,222 @@
+#include "keyindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int newNode(KeyIndex *index, int attr)
+{
+  if (index->nodeCount == index->nodeCapacity)
+  {
+    int capacity = index->nodeCapacity * 2;
+    KeyIndexNode *nodes = realloc(index->nodes, sizeof(KeyIndexNode) * capacity);
+    if (!nodes)
+      return -1;
+    index->nodes = nodes;
+    index->nodeCapacity = capacity;
+  }
+
+  KeyIndexNode *node = &index->nodes[index->nodeCount];
+  node->attr = attr;
+  node->firstChild = -1;
+  node->nextSibling = -1;
+  node->key = -1;
+  node->liveKeys = 0;
+  return index->nodeCount++;
+}
+
+int initKeyIndex(KeyIndex *index)
+{
+  memset(index, 0, sizeof(KeyIndex));
+
+  index->nodeCapacity = 64;
+  index->nodes = malloc(sizeof(KeyIndexNode) * index->nodeCapacity);
+  index->keyCapacity = 16;
+  index->keys = malloc(sizeof(attrset) * index->keyCapacity);
+  index->alive = malloc(index->keyCapacity);
+
+  /* Raiz: o conjunto vazio */
+  if (!index->nodes || !index->keys || !index->alive || newNode(index, -1) != 0)
+  {
+    freeKeyIndex(index);
+    return -1;
+  }
+  return 0;
+}
+
+void freeKeyIndex(KeyIndex *index)
+{
+  free(index->nodes);
+  free(index->keys);
+  free(index->alive);
+  memset(index, 0, sizeof(KeyIndex));
+}
+
+// Filho de parent com o atributo attr, criado na posição ordenada se falta
+static int childWithAttr(KeyIndex *index, int parent, int attr)
+{
+  int previous = -1;
+  int c = index->nodes[parent].firstChild;
+  while (c >= 0 && index->nodes[c].attr < attr)
+  {
+    previous = c;
+    c = index->nodes[c].nextSibling;
+  }
+  if (c >= 0 && index->nodes[c].attr == attr)
+    return c;
+
+  int child = newNode(index, attr);
+  if (child < 0)
+    return -1;
+
+  index->nodes[child].nextSibling = c;
+  if (previous < 0)
+    index->nodes[parent].firstChild = child;
+  else
+    index->nodes[previous].nextSibling = child;
+  return child;
+}
+
+int keyIndexInsert(KeyIndex *index, attrset key)
+{
+  int path[ATTRSET_MAX_ATTRS + 1];
+  int depth = 0;
+
+  path[depth++] = 0;
+  for (int a = attrsetNext(key, 0); a >= 0; a = attrsetNext(key, a + 1))
+  {
+    int child = childWithAttr(index, path[depth - 1], a);
+    if (child < 0)
+      return -1;
+    path[depth++] = child;
+  }
+
+  KeyIndexNode *terminal = &index->nodes[path[depth - 1]];
+  if (terminal->key >= 0 && index->alive[terminal->key])
+    return 0;
+
+  if (terminal->key < 0)
+  {
+    if (index->keyCount == index->keyCapacity)
+    {
+      int capacity = index->keyCapacity * 2;
+      attrset *keys = realloc(index->keys, sizeof(attrset) * capacity);
+      if (!keys)
+        return -1;
+      index->keys = keys;
+
+      char *alive = realloc(index->alive, capacity);
+      if (!alive)
+        return -1;
+      index->alive = alive;
+      index->keyCapacity = capacity;
+    }
+
+    terminal->key = index->keyCount++;
+    index->keys[terminal->key] = key;
+  }
+
+  index->alive[terminal->key] = 1;
+  index->liveCount++;
+  for (int d = 0; d < depth; ++d)
+    index->nodes[path[d]].liveKeys++;
+  return 0;
+}
+
+// Maior atributo de X, ou -1
+static int lastAttr(attrset X)
+{
+  for (int w = activeAttrsetWords() - 1; w >= 0; --w)
+    if (X.w[w])
+      return (w << 6) + 63 - __builtin_clzll(X.w[w]);
+  return -1;
+}
+
+static int findSubset(const KeyIndex *index, int node, attrset X, int maxAttr, attrset *out)
+{
+  const KeyIndexNode *current = &index->nodes[node];
+  if (current->key >= 0 && index->alive[current->key])
+  {
+    if (out)
+      *out = index->keys[current->key];
+    return 1;
+  }
+
+  for (int c = current->firstChild; c >= 0; c = index->nodes[c].nextSibling)
+  {
+    const KeyIndexNode *child = &index->nodes[c];
+    if (child->attr > maxAttr)
+      break;
+    if (child->liveKeys > 0 && attrsetHas(X, child->attr) && findSubset(index, c, X, maxAttr, out))
+      return 1;
+  }
+  return 0;
+}
+
+int keyIndexFindSubset(const KeyIndex *index, attrset X, attrset *out)
+{
+  if (index->liveCount == 0)
+    return 0;
+  return findSubset(index, 0, X, lastAttr(X), out);
+}
+
+/* attrs: atributos de X em ordem crescente; next: o próximo ainda não
+   encontrado no caminho. Com todos encontrados, a subárvore inteira sai. */
+static int removeSupersets(KeyIndex *index, int node, const int *attrs, int count, int next)
+{
+  int removed = 0;
+
+  KeyIndexNode *current = &index->nodes[node];
+  if (next == count && current->key >= 0 && index->alive[current->key])
+  {
+    index->alive[current->key] = 0;
+    removed++;
+  }
+
+  for (int c = current->firstChild; c >= 0; c = index->nodes[c].nextSibling)
+  {
+    const KeyIndexNode *child = &index->nodes[c];
+    if (next < count && child->attr > attrs[next])
+      break;
+    if (child->liveKeys == 0)
+      continue;
+
+    int childNext = (next < count && child->attr == attrs[next]) ? next + 1 : next;
+    removed += removeSupersets(index, c, attrs, count, childNext);
+  }
+
+  current->liveKeys -= removed;
+  return removed;
+}
+
+int keyIndexRemoveSupersets(KeyIndex *index, attrset X)
+{
+  if (index->liveCount == 0)
+    return 0;
+
+  int attrs[ATTRSET_MAX_ATTRS];
+  int count = 0;
+  for (int a = attrsetNext(X, 0); a >= 0; a = attrsetNext(X, a + 1))
+    attrs[count++] = a;
+
+  int removed = removeSupersets(index, 0, attrs, count, 0);
+  index->liveCount -= removed;
+  return removed;
+}
+
+attrset *keyIndexToArray(const KeyIndex *index, int *outCount)
+{
+  *outCount = 0;
+  if (index->liveCount == 0)
+    return NULL;
+
+  attrset *keys = malloc(sizeof(attrset) * index->liveCount);
+  if (!keys)
+    return NULL;
+
+  int count = 0;
+  for (int k = 0; k < index->keyCount; ++k)
+    if (index->alive[k])
+      keys[count++] = index->keys[k];
+
+  *outCount = count;
+  return keys;
+}
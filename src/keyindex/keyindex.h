@@ -0,0 +1,66 @@
+#ifndef KEYINDEX_H
+#define KEYINDEX_H
+
+#include <stddef.h>
+#include "attrset.h"
+
+/* -----------------------------------------------------------------------------
+   Índice de consultas por subconjunto sobre uma antichain de chaves
+   (set-trie).
+
+   Cada chave é um caminho da raiz pelos seus atributos em ordem crescente;
+   os filhos de cada nó ficam ordenados por atributo. As consultas só descem
+   pelos ramos compatíveis:
+     - "alguma chave ⊆ X": só filhos cujo atributo está em X;
+     - "remover chaves ⊇ X": filhos com atributo menor que o próximo de X,
+       ou igual a ele; um filho maior encerra a lista.
+   Cada nó conta as chaves vivas na sua subárvore, e ramos vazios são
+   pulados. Remover só marca: os nós ficam para inserções futuras.
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  int attr;
+  int firstChild;  // -1 = folha
+  int nextSibling; // -1 = último
+  int key;         // chave que termina aqui, ou -1
+  int liveKeys;    // chaves vivas na subárvore
+} KeyIndexNode;
+
+typedef struct
+{
+  KeyIndexNode *nodes;
+  int nodeCount;
+  int nodeCapacity;
+
+  attrset *keys;
+  char *alive;
+  int keyCount; // inseridas (vivas ou não)
+  int keyCapacity;
+  int liveCount;
+} KeyIndex;
+
+// 0 ou -1 sem memória
+int initKeyIndex(KeyIndex *index);
+void freeKeyIndex(KeyIndex *index);
+
+/* Insere a chave (ignorada se já está). A antichain é de quem chama:
+   normalmente só se insere K depois de keyIndexHasSubset(K) == 0.
+   -1 sem memória. */
+int keyIndexInsert(KeyIndex *index, attrset key);
+
+// 1 se alguma chave guardada ⊆ X (*out recebe uma delas, se out != NULL)
+int keyIndexFindSubset(const KeyIndex *index, attrset X, attrset *out);
+
+static inline int keyIndexHasSubset(const KeyIndex *index, attrset X)
+{
+  return keyIndexFindSubset(index, X, NULL);
+}
+
+// Remove todas as chaves ⊇ X; retorna quantas saíram
+int keyIndexRemoveSupersets(KeyIndex *index, attrset X);
+
+/* Chaves vivas, na ordem de inserção, num vetor novo (NULL se não há
+   nenhuma ou falta memória) */
+attrset *keyIndexToArray(const KeyIndex *index, int *outCount);
+
+#endif
@@ -1,142 +1,1132 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "keys.h"
 #include "closure.h"
+#include "visited.h"
+#include "keyindex.h"
+#include "stats.h"
+#include "arena.h"
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+static KeyAlgorithm currentAlgorithm = KEYS_ALGO_BFS;
 
-attrset *computeCandidateKeys(attrset U, FD *fds, int fdCount, int *outCount)
+void setKeyAlgorithm(KeyAlgorithm algorithm)
 {
-  attrset allRhsAttributes = 0;
+  currentAlgorithm = algorithm;
+}
+
+KeyAlgorithm getKeyAlgorithm(void)
+{
+  return currentAlgorithm;
+}
+
+static int currentThreads = 1;
+
+/* Estados cujos fechos são calculados juntos (fecho bit-sliced) */
+#define KEYS_BATCH 256
+
+/* Nós da DFS entre duas consultas ao relógio */
+#define KEYS_CLOCK_INTERVAL 256
+
+/* Buscas dirigidas extras do oráculo de primos, uma por FD cujo LHS
+   contém o atributo */
+#define KEYS_ORACLE_ATTEMPTS 8
+
+void setKeyThreads(int threads)
+{
+  if (threads <= 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (int)online : 1;
+  }
+  currentThreads = threads;
+}
+
+int getKeyThreads(void)
+{
+  return currentThreads;
+}
+
+/* ---------------------------------------------------------
+   Classes dos atributos de U, pelas FDs (só a parte não
+   trivial de cada RHS conta):
+     L (só em LHS) e N (em nenhuma FD): estão em toda chave;
+     R (só em RHS): não estão em nenhuma chave;
+     LR (nos dois lados): o único espaço de busca.
+--------------------------------------------------------- */
+typedef struct
+{
+  attrset U;
+  attrset essential; // L ∪ N
+  attrset rhsOnly;   // R
+  attrset search;    // LR
+} AttributeClasses;
+
+static AttributeClasses classifyAttributes(attrset U, const FD *fds, int fdCount)
+{
+  attrset lhsAttributes = attrsetEmpty();
+  attrset rhsAttributes = attrsetEmpty();
   for (int i = 0; i < fdCount; ++i)
-    allRhsAttributes |= fds[i].rhs;
+  {
+    lhsAttributes = attrsetUnion(lhsAttributes, fds[i].lhs);
+    rhsAttributes = attrsetUnion(rhsAttributes, attrsetMinus(fds[i].rhs, fds[i].lhs));
+  }
+
+  AttributeClasses classes;
+  classes.U = U;
+  classes.essential = attrsetMinus(U, rhsAttributes);
+  classes.rhsOnly = attrsetMinus(attrsetIntersect(U, rhsAttributes), lhsAttributes);
+  classes.search = attrsetIntersect(attrsetIntersect(U, rhsAttributes), lhsAttributes);
+  return classes;
+}
 
-  attrset essentialAttributes = U & ~allRhsAttributes;
-  attrset remainingAttributes = U & ~essentialAttributes;
+/* ---------------------------------------------------------
+   BFS sobre os superconjuntos dos atributos essenciais
+--------------------------------------------------------- */
+static attrset *bfsCandidateKeys(const AttributeClasses *classes,
+                                 ClosureIndex *closureIndex, int *outCount)
+{
+  attrset U = classes->U;
+  attrset essentialAttributes = classes->essential;
+  attrset remainingAttributes = classes->search;
 
+  Arena *scratch = getScratchArena();
   int queueCapacity = 256;
-  attrset *queue = malloc(sizeof(attrset) * queueCapacity);
+  attrset *queue = scratchAlloc(scratch, sizeof(attrset) * queueCapacity);
   int queueHead = 0, queueTail = 0;
+  if (!queue)
+  {
+    *outCount = 0;
+    return NULL;
+  }
 
-  int visitedCapacity = 1024;
-  attrset *visited = malloc(sizeof(attrset) * visitedCapacity);
-  int visitedCount = 0;
+  /* Todos os estados são E ∪ (subconjunto de remainingAttributes):
+     só os atributos restantes distinguem os conjuntos visitados */
+  VisitedSet visited;
+  if (initVisitedSet(&visited, remainingAttributes) != 0)
+  {
+    freeVisitedSet(&visited);
+    scratchFree(scratch, queue);
+    *outCount = 0;
+    return NULL;
+  }
 
-  int keyCapacity = 1024;
-  attrset *candidateKeys = malloc(sizeof(attrset) * keyCapacity);
-  int keyCount = 0;
+  /* Antichain das chaves encontradas, com consultas por subconjunto */
+  KeyIndex keyIndex;
+  if (initKeyIndex(&keyIndex) != 0)
+  {
+    freeVisitedSet(&visited);
+    scratchFree(scratch, queue);
+    *outCount = 0;
+    return NULL;
+  }
+  int failed = 0;
 
   /* Inicializa BFS com os atributos essenciais */
   queue[queueTail++] = essentialAttributes;
-  visited[visitedCount++] = essentialAttributes;
+  visitedInsert(&visited, essentialAttributes);
 
   /* ------------------------------------------------------
      BFS para gerar candidatos e testar minimalidade
   ------------------------------------------------------ */
-  while (queueHead < queueTail)
+  attrset closures[KEYS_BATCH];
+  int batchBegin = 0, batchEnd = 0;
+
+  while (queueHead < queueTail && !failed)
   {
-    attrset currentSet = queue[queueHead++];
-    attrset closureOfCurrent = computeClosure(currentSet, fds, fdCount);
+    /* Os testes de superchave são feitos em lote, bloco a bloco da fila */
+    if (queueHead >= batchEnd)
+    {
+      batchBegin = queueHead;
+      batchEnd = queueTail - queueHead < KEYS_BATCH ? queueTail : queueHead + KEYS_BATCH;
+      computeClosureBatch(closureIndex, queue + batchBegin, closures, batchEnd - batchBegin);
+    }
+
+    attrset currentSet = queue[queueHead];
+    attrset closureOfCurrent = closures[queueHead - batchBegin];
+    queueHead++;
+    STATS_COUNT(STAT_KEY_STATES, 1);
 
     /* --------------------------------------------------
        Se o fecho é superchave → possível chave candidata
     -------------------------------------------------- */
-    if ((closureOfCurrent & U) == U)
+    if (attrsetIsSubset(U, closureOfCurrent))
     {
-      int isMinimal = 1;
-
-      /* Verifica se alguma chave existente é subconjunto da atual */
-      for (int i = 0; i < keyCount; ++i)
+      /* Minimal se nenhuma chave existente é subconjunto da atual */
+      if (!keyIndexHasSubset(&keyIndex, currentSet))
       {
-        if ((currentSet & candidateKeys[i]) == candidateKeys[i])
-        {
-          isMinimal = 0;
-          break;
-        }
-      }
-
-      if (isMinimal)
-      {
-        /* Remove candidatos não minimal frente ao novo */
-        int w = 0;
-        for (int i = 0; i < keyCount; ++i)
-        {
-          if ((candidateKeys[i] & currentSet) != currentSet)
-            candidateKeys[w++] = candidateKeys[i];
-        }
-        keyCount = w;
-
-        /* Adiciona a nova chave */
-        if (keyCount + 1 >= keyCapacity)
-        {
-          keyCapacity *= 2;
-          candidateKeys = realloc(candidateKeys, sizeof(attrset) * keyCapacity);
-        }
-
-        candidateKeys[keyCount++] = currentSet;
+        /* Remove candidatos não minimais frente ao novo e o adiciona */
+        keyIndexRemoveSupersets(&keyIndex, currentSet);
+        failed = keyIndexInsert(&keyIndex, currentSet) != 0;
       }
 
       continue;
     }
 
     /* --------------------------------------------------
-       Expande o conjunto tentando adicionar atributos restantes
+       Expande o conjunto tentando adicionar atributos restantes.
+       Poda:
+         - atributos já no fecho: o sucessor teria o mesmo fecho do
+           atual e nenhum superconjunto dele seria chave mínima;
+         - superconjuntos de chaves já encontradas.
+       Conjuntos com um fecho já visto não são podados: conjuntos
+       diferentes com o mesmo fecho podem ser chaves diferentes (com
+       A->C, C->A e U=ABC, AB e CB têm fecho ABC e as duas são chaves).
     -------------------------------------------------- */
-    for (int b = 0; b < 26; ++b)
+    attrset candidates = attrsetMinus(remainingAttributes, closureOfCurrent);
+    for (int b = attrsetNext(candidates, 0); b >= 0; b = attrsetNext(candidates, b + 1))
     {
-      attrset bit = (1u << b);
-      if (!(remainingAttributes & bit))
-        continue;
-      if (currentSet & bit)
+      attrset nextSet = attrsetWith(currentSet, b);
+
+      if (keyIndexHasSubset(&keyIndex, nextSet))
         continue;
 
-      attrset nextSet = currentSet | bit;
+      /* Registra como visitado; ignora se já estava */
+      if (visitedInsert(&visited, nextSet) != 1)
+        continue;
 
-      /* Verifica se já foi visitado */
-      int hasSeen = 0;
-      for (int i = 0; i < visitedCount; ++i)
+      /* Adiciona à fila */
+      if (queueTail + 1 >= queueCapacity)
       {
-        if (visited[i] == nextSet)
+        attrset *grown = scratchRealloc(scratch, queue, sizeof(attrset) * queueCapacity,
+                                        sizeof(attrset) * queueCapacity * 2);
+        if (!grown)
         {
-          hasSeen = 1;
+          failed = 1;
           break;
         }
+        queue = grown;
+        queueCapacity *= 2;
       }
+      queue[queueTail++] = nextSet;
+    }
+  }
 
-      if (hasSeen)
-        continue;
+  /* Limpeza de estruturas temporárias */
+  scratchFree(scratch, queue);
+  freeVisitedSet(&visited);
 
-      /* Registra como visitado */
-      if (visitedCount + 1 >= visitedCapacity)
-      {
-        visitedCapacity *= 2;
-        visited = realloc(visited, sizeof(attrset) * visitedCapacity);
-      }
-      visited[visitedCount++] = nextSet;
+  attrset *candidateKeys = failed ? NULL : keyIndexToArray(&keyIndex, outCount);
+  if (failed)
+    *outCount = 0;
+  freeKeyIndex(&keyIndex);
 
-      /* Adiciona à fila */
-      if (queueTail + 1 >= queueCapacity)
-      {
-        queueCapacity *= 2;
-        queue = realloc(queue, sizeof(attrset) * queueCapacity);
-      }
-      queue[queueTail++] = nextSet;
+  return candidateKeys;
+}
+
+/* ---------------------------------------------------------
+   BFS paralela, sincronizada por nível.
+
+   O nível atual é repartido entre deques por thread (intervalos
+   de índices da fronteira). Cada thread consome o seu deque pelo
+   início e, quando ele esvazia, rouba metade do deque de outra
+   thread pelo fim. Os sucessores vão para buffers locais que
+   formam o próximo nível.
+
+   A antichain de chaves só muda entre níveis: durante um nível
+   ela é lida sem travas, e as chaves novas ficam em listas por
+   thread, publicadas na barreira. Como as chaves de um nível têm
+   todas o mesmo tamanho, nenhuma é subconjunto de outra.
+--------------------------------------------------------- */
+#define KEYS_STEAL_CHUNK 64
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  size_t head;
+  size_t tail;
+} WorkDeque;
+
+typedef struct
+{
+  attrset *items;
+  size_t count;
+  size_t capacity;
+} AttrsetBuffer;
+
+typedef struct BfsShared BfsShared;
+
+typedef struct
+{
+  BfsShared *shared;
+  int id;
+  AttrsetBuffer next;
+  AttrsetBuffer keys;
+  int failed;
+} BfsWorker;
+
+struct BfsShared
+{
+  attrset U;
+  attrset remainingAttributes;
+  const ClosureIndex *closureIndex;
+  SharedVisitedSet visited;
+
+  const attrset *frontier;
+  KeyIndex keyIndex; // chaves dos níveis anteriores, só lida durante um nível
+
+  WorkDeque *deques;
+  BfsWorker *workers;
+  int threadCount;
+  int attrWords; // largura de conjuntos da thread que dispara os níveis
+};
+
+static int bufferPush(AttrsetBuffer *buffer, attrset s)
+{
+  if (buffer->count >= buffer->capacity)
+  {
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+    attrset *items = realloc(buffer->items, sizeof(attrset) * capacity);
+    if (!items)
+      return -1;
+    buffer->items = items;
+    buffer->capacity = capacity;
+  }
+  buffer->items[buffer->count++] = s;
+  return 0;
+}
+
+static int containsKnownKey(const BfsShared *shared, attrset s)
+{
+  return keyIndexHasSubset(&shared->keyIndex, s);
+}
+
+// Retira até KEYS_STEAL_CHUNK itens do início do próprio deque
+static int takeOwnWork(WorkDeque *deque, size_t *begin, size_t *end)
+{
+  pthread_mutex_lock(&deque->lock);
+  size_t available = deque->tail - deque->head;
+  size_t take = available < KEYS_STEAL_CHUNK ? available : KEYS_STEAL_CHUNK;
+  *begin = deque->head;
+  *end = deque->head + take;
+  deque->head += take;
+  pthread_mutex_unlock(&deque->lock);
+  return take > 0;
+}
+
+// Rouba metade do trabalho restante de outra thread, pelo fim
+static int stealWork(BfsShared *shared, int thief)
+{
+  for (int k = 1; k < shared->threadCount; ++k)
+  {
+    WorkDeque *victim = &shared->deques[(thief + k) % shared->threadCount];
+
+    pthread_mutex_lock(&victim->lock);
+    size_t available = victim->tail - victim->head;
+    size_t take = available - available / 2;
+    size_t begin = victim->tail - take;
+    size_t end = victim->tail;
+    victim->tail = begin;
+    pthread_mutex_unlock(&victim->lock);
+
+    if (take > 0)
+    {
+      WorkDeque *own = &shared->deques[thief];
+      pthread_mutex_lock(&own->lock);
+      own->head = begin;
+      own->tail = end;
+      pthread_mutex_unlock(&own->lock);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void expandState(BfsWorker *worker, attrset currentSet, attrset closureOfCurrent)
+{
+  STATS_COUNT(STAT_KEY_STATES, 1);
+  BfsShared *shared = worker->shared;
+
+  if (attrsetIsSubset(shared->U, closureOfCurrent))
+  {
+    /* Todo subconjunto próprio tem tamanho menor: só as chaves de
+       níveis anteriores podem torná-lo não minimal */
+    if (!containsKnownKey(shared, currentSet) && bufferPush(&worker->keys, currentSet) != 0)
+      worker->failed = 1;
+    return;
+  }
+
+  attrset candidates = attrsetMinus(shared->remainingAttributes, closureOfCurrent);
+  for (int b = attrsetNext(candidates, 0); b >= 0; b = attrsetNext(candidates, b + 1))
+  {
+    attrset nextSet = attrsetWith(currentSet, b);
+
+    if (containsKnownKey(shared, nextSet))
+      continue;
+
+    int inserted = sharedVisitedInsert(&shared->visited, nextSet);
+    if (inserted < 0 || (inserted == 1 && bufferPush(&worker->next, nextSet) != 0))
+      worker->failed = 1;
+  }
+}
+
+static void *bfsWorkerMain(void *arg)
+{
+  BfsWorker *worker = arg;
+  BfsShared *shared = worker->shared;
+  attrset closures[KEYS_STEAL_CHUNK];
+  size_t begin, end;
+
+  attrsetUseWords(shared->attrWords);
+
+  for (;;)
+  {
+    if (!takeOwnWork(&shared->deques[worker->id], &begin, &end))
+    {
+      if (!stealWork(shared, worker->id))
+        break;
+      continue;
+    }
+
+    computeClosureBatch(shared->closureIndex, shared->frontier + begin, closures, (int)(end - begin));
+
+    for (size_t i = begin; i < end; ++i)
+      expandState(worker, shared->frontier[i], closures[i - begin]);
+  }
+
+  return NULL;
+}
+
+static attrset *parallelBfsCandidateKeys(const AttributeClasses *classes,
+                                         ClosureIndex *closureIndex, int threadCount,
+                                         int *outCount)
+{
+  attrset essentialAttributes = classes->essential;
+
+  BfsShared shared = {0};
+  shared.U = classes->U;
+  shared.remainingAttributes = classes->search;
+  shared.closureIndex = closureIndex;
+  shared.threadCount = threadCount;
+  shared.attrWords = activeAttrsetWords();
+
+  AttrsetBuffer frontier = {0};
+  AttrsetBuffer keys = {0};
+  int failed = 0;
+
+  shared.deques = calloc(threadCount, sizeof(WorkDeque));
+  shared.workers = calloc(threadCount, sizeof(BfsWorker));
+  pthread_t *threads = malloc(sizeof(pthread_t) * threadCount);
+
+  if (!shared.deques || !shared.workers || !threads || initKeyIndex(&shared.keyIndex) != 0 ||
+      initSharedVisitedSet(&shared.visited, shared.remainingAttributes) != 0 ||
+      bufferPush(&frontier, essentialAttributes) != 0)
+    failed = 1;
+
+  for (int t = 0; t < threadCount && !failed; ++t)
+  {
+    pthread_mutex_init(&shared.deques[t].lock, NULL);
+    shared.workers[t].shared = &shared;
+    shared.workers[t].id = t;
+  }
+
+  if (!failed)
+    sharedVisitedInsert(&shared.visited, essentialAttributes);
+
+  /* Um nível por iteração */
+  while (!failed && frontier.count > 0)
+  {
+    shared.frontier = frontier.items;
+
+    /* Reparte a fronteira em blocos contíguos */
+    for (int t = 0; t < threadCount; ++t)
+    {
+      shared.deques[t].head = frontier.count * t / threadCount;
+      shared.deques[t].tail = frontier.count * (t + 1) / threadCount;
+      shared.workers[t].next.count = 0;
+      shared.workers[t].keys.count = 0;
+    }
+
+    for (int t = 0; t < threadCount; ++t)
+      pthread_create(&threads[t], NULL, bfsWorkerMain, &shared.workers[t]);
+    for (int t = 0; t < threadCount; ++t)
+      pthread_join(threads[t], NULL);
+
+    /* Barreira: publica as chaves e monta o próximo nível */
+    frontier.count = 0;
+    for (int t = 0; t < threadCount && !failed; ++t)
+    {
+      BfsWorker *worker = &shared.workers[t];
+      failed |= worker->failed;
+
+      for (size_t i = 0; i < worker->keys.count && !failed; ++i)
+        failed |= bufferPush(&keys, worker->keys.items[i]) != 0 ||
+                  keyIndexInsert(&shared.keyIndex, worker->keys.items[i]) != 0;
+      for (size_t i = 0; i < worker->next.count && !failed; ++i)
+        failed |= bufferPush(&frontier, worker->next.items[i]) != 0;
     }
   }
 
   /* Limpeza de estruturas temporárias */
-  free(queue);
-  free(visited);
+  for (int t = 0; t < threadCount && shared.workers; ++t)
+  {
+    free(shared.workers[t].next.items);
+    free(shared.workers[t].keys.items);
+    if (shared.deques)
+      pthread_mutex_destroy(&shared.deques[t].lock);
+  }
+  freeSharedVisitedSet(&shared.visited);
+  freeKeyIndex(&shared.keyIndex);
+  free(shared.deques);
+  free(shared.workers);
+  free(threads);
+  free(frontier.items);
+
+  if (failed)
+  {
+    free(keys.items);
+    *outCount = 0;
+    return NULL;
+  }
+
+  *outCount = (int)keys.count;
+  return keys.items;
+}
+
+// X+, pelo cache de fechos quando há um
+static attrset indexedClosure(ClosureIndex *closureIndex, ClosureCache *cache, attrset X)
+{
+  return cache ? cachedClosure(cache, closureIndex, X) : computeClosureIndexed(closureIndex, X);
+}
+
+/* U ⊆ X+, pelo cache de fechos quando há um (o fecho inteiro é
+   guardado); sem cache, o fecho para assim que alcança U */
+static int isSuperkey(ClosureIndex *closureIndex, ClosureCache *cache, attrset U, attrset X)
+{
+  if (cache)
+    return attrsetIsSubset(U, cachedClosure(cache, closureIndex, X));
+  return closureImplies(closureIndex, X, U);
+}
+
+/* ---------------------------------------------------------
+   Reduz uma superchave S a uma chave: remove, em ordem, cada
+   atributo cuja ausência ainda determina U
+--------------------------------------------------------- */
+static attrset minimizeSuperkey(attrset U, attrset S, attrset essentialAttributes,
+                                ClosureIndex *closureIndex, ClosureCache *cache)
+{
+  attrset removable = attrsetMinus(S, essentialAttributes);
+
+  for (int b = attrsetNext(removable, 0); b >= 0; b = attrsetNext(removable, b + 1))
+  {
+    attrset reduced = attrsetWithout(S, b);
+    if (isSuperkey(closureIndex, cache, U, reduced))
+      S = reduced;
+  }
+
+  return S;
+}
+
+/* ---------------------------------------------------------
+   Lucchesi–Osborn: cada chave K e cada FD X -> Y geram a
+   superchave X ∪ (K \ Y); se ela não contém nenhuma chave
+   conhecida, sua minimização é uma chave nova. O custo é
+   polinomial em |U|, |F| e no número de chaves.
+--------------------------------------------------------- */
+static attrset *lucchesiOsbornKeys(const AttributeClasses *classes, const FD *fds, int fdCount,
+                                   ClosureIndex *closureIndex, int *outCount)
+{
+  attrset U = classes->U;
+  attrset essentialAttributes = classes->essential;
+
+  /* As chaves nunca saem do índice: keyIndex.keys[0..keyCount) é a
+     lista de trabalho, na ordem em que foram encontradas */
+  KeyIndex keyIndex;
+  *outCount = 0;
+  if (initKeyIndex(&keyIndex) != 0)
+    return NULL;
+
+  /* U \ R é superchave: todo atributo de R sai de um LHS sem R */
+  int failed = keyIndexInsert(&keyIndex, minimizeSuperkey(U, attrsetMinus(U, classes->rhsOnly),
+                                                          essentialAttributes, closureIndex, NULL)) != 0;
+
+  for (int k = 0; k < keyIndex.keyCount && !failed; ++k)
+  {
+    for (int i = 0; i < fdCount && !failed; ++i)
+    {
+      attrset K = keyIndex.keys[k];
+
+      /* Y disjunto de K: S contém K */
+      if (!attrsetIntersects(fds[i].rhs, K))
+        continue;
+
+      attrset S = attrsetIntersect(U, attrsetUnion(fds[i].lhs, attrsetMinus(K, fds[i].rhs)));
+      STATS_COUNT(STAT_KEY_STATES, 1);
+      if (keyIndexHasSubset(&keyIndex, S))
+        continue;
+
+      failed = keyIndexInsert(&keyIndex, minimizeSuperkey(U, S, essentialAttributes, closureIndex, NULL)) != 0;
+    }
+  }
+
+  attrset *candidateKeys = failed ? NULL : keyIndexToArray(&keyIndex, outCount);
+  if (failed)
+    *outCount = 0;
+  freeKeyIndex(&keyIndex);
+  return candidateKeys;
+}
 
-  /* Não encontrou nenhuma chave? */
-  if (keyCount == 0)
+/* ---------------------------------------------------------
+   DFS com memória limitada pela profundidade.
+
+   Cada conjunto E ∪ S (S ⊆ LR) é gerado uma única vez,
+   acrescentando atributos em ordem crescente de índice, e só
+   atributos fora do fecho do conjunto atual. Poda:
+     - algum atributo de S determinado pelos demais: nenhum
+       superconjunto é chave mínima;
+     - superchave: é chave (os atributos são irredundantes) e
+       não é estendida;
+     - nem somando todos os atributos ainda permitidos o
+       conjunto vira superchave.
+   Nenhuma chave precisa ser guardada para testar minimalidade,
+   então a pilha (um quadro por nível) é toda a memória usada.
+--------------------------------------------------------- */
+typedef struct
+{
+  attrset set;
+  attrset candidates;
+} DfsFrame;
+
+typedef enum
+{
+  DFS_PRUNED,
+  DFS_KEY,
+  DFS_EXPAND
+} DfsVisit;
+
+// Atributos de s com índice > a
+static attrset attrsAbove(attrset s, int a)
+{
+  for (int w = 0, words = activeAttrsetWords(); w <= a >> 6 && w < words; ++w)
+    s.w[w] &= (w < a >> 6 || (a & 63) == 63) ? 0 : ~(uint64_t)0 << ((a & 63) + 1);
+  return s;
+}
+
+static DfsVisit dfsVisit(const AttributeClasses *classes, ClosureIndex *closureIndex,
+                         attrset set, int added, attrset *outCandidates)
+{
+  STATS_COUNT(STAT_KEY_STATES, 1);
+  /* O atributo acrescentado não está no fecho do pai; os anteriores
+     podem ter passado a ser determinados */
+  attrset earlier = attrsetIntersect(set, classes->search);
+  if (added >= 0)
+    attrsetErase(&earlier, added);
+
+  for (int a = attrsetNext(earlier, 0); a >= 0; a = attrsetNext(earlier, a + 1))
+    if (closureImplies(closureIndex, attrsetWithout(set, a), attrsetSingleton(a)))
+      return DFS_PRUNED;
+
+  attrset closure = computeClosureIndexed(closureIndex, set);
+  if (attrsetIsSubset(classes->U, closure))
+    return DFS_KEY;
+
+  attrset allowed = added >= 0 ? attrsAbove(classes->search, added) : classes->search;
+  allowed = attrsetMinus(allowed, closure);
+  if (!closureImplies(closureIndex, attrsetUnion(set, allowed), classes->U))
+    return DFS_PRUNED;
+
+  *outCandidates = allowed;
+  return DFS_EXPAND;
+}
+
+static double secondsSince(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static KeyEnumStatus dfsEnumerateKeys(const AttributeClasses *classes, ClosureIndex *closureIndex,
+                                      const KeyLimits *limits, KeyCallback callback, void *context,
+                                      long *outCount)
+{
+  *outCount = 0;
+
+  Arena *scratch = getScratchArena();
+  DfsFrame *stack = scratchAlloc(scratch, sizeof(DfsFrame) * (attrsetCount(classes->search) + 1));
+  if (!stack)
+    return KEYS_FAILED;
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  long keyCount = 0;
+  long nodes = 0;
+  int top = 0;
+  KeyEnumStatus status = KEYS_COMPLETE;
+
+  attrset candidates;
+  DfsVisit visit = dfsVisit(classes, closureIndex, classes->essential, -1, &candidates);
+  if (visit == DFS_KEY)
+  {
+    keyCount++;
+    if (callback(classes->essential, context))
+      status = KEYS_STOPPED;
+  }
+  else if (visit == DFS_EXPAND)
+  {
+    stack[top].set = classes->essential;
+    stack[top].candidates = candidates;
+    top++;
+  }
+
+  while (top > 0 && status == KEYS_COMPLETE)
+  {
+    DfsFrame *frame = &stack[top - 1];
+    int b = attrsetNext(frame->candidates, 0);
+    if (b < 0)
+    {
+      top--;
+      continue;
+    }
+    attrsetErase(&frame->candidates, b);
+
+    if (limits && limits->timeBudget > 0 && ++nodes % KEYS_CLOCK_INTERVAL == 0 &&
+        secondsSince(&start) >= limits->timeBudget)
+    {
+      status = KEYS_TIME_LIMIT;
+      break;
+    }
+
+    attrset nextSet = attrsetWith(frame->set, b);
+    visit = dfsVisit(classes, closureIndex, nextSet, b, &candidates);
+
+    if (visit == DFS_KEY)
+    {
+      keyCount++;
+      if (callback(nextSet, context))
+        status = KEYS_STOPPED;
+      else if (limits && limits->maxKeys > 0 && keyCount >= limits->maxKeys)
+        status = KEYS_KEY_LIMIT;
+    }
+    else if (visit == DFS_EXPAND)
+    {
+      stack[top].set = nextSet;
+      stack[top].candidates = candidates;
+      top++;
+    }
+  }
+
+  scratchFree(scratch, stack);
+  *outCount = keyCount;
+  return status;
+}
+
+static int collectKey(attrset key, void *context)
+{
+  return bufferPush(context, key) != 0;
+}
+
+static attrset *dfsCandidateKeys(const AttributeClasses *classes, ClosureIndex *closureIndex, int *outCount)
+{
+  AttrsetBuffer keys = {0};
+  long keyCount = 0;
+
+  if (dfsEnumerateKeys(classes, closureIndex, NULL, collectKey, &keys, &keyCount) != KEYS_COMPLETE)
+  {
+    free(keys.items);
+    *outCount = 0;
+    return NULL;
+  }
+
+  *outCount = (int)keys.count;
+  return keys.items;
+}
+
+/* ---------------------------------------------------------
+   Oráculo de atributos primos
+--------------------------------------------------------- */
+
+/* Reduz a superchave S (que contém a) a uma superchave mínima
+   exceto, talvez, por a: tira primeiro os atributos de first,
+   depois os demais, cada um se S continuar superchave. Se sem a
+   ela deixa de ser superchave, é uma chave que contém a. */
+static int keyWithAttributeFound(attrset U, attrset S, attrset essentialAttributes, ClosureIndex *closureIndex,
+                                 ClosureCache *cache, int a, attrset first)
+{
+  attrset removable = attrsetWithout(attrsetMinus(S, essentialAttributes), a);
+  attrset passes[2] = {attrsetIntersect(removable, first), attrsetMinus(removable, first)};
+
+  for (int p = 0; p < 2; ++p)
+  {
+    for (int b = attrsetNext(passes[p], 0); b >= 0; b = attrsetNext(passes[p], b + 1))
+    {
+      attrset reduced = attrsetWithout(S, b);
+      if (isSuperkey(closureIndex, cache, U, reduced))
+        S = reduced;
+    }
+  }
+
+  return !isSuperkey(closureIndex, cache, U, attrsetWithout(S, a));
+}
+
+PrimeVerdict primeAttributeOracle(attrset U, const FD *fds, int fdCount, ClosureIndex *closureIndex,
+                                  ClosureCache *cache, int a)
+{
+  STATS_COUNT(STAT_PRIME_ORACLE_CALLS, 1);
+  AttributeClasses classes = classifyAttributes(U, fds, fdCount);
+
+  /* Fora de todo RHS: está em toda chave */
+  if (attrsetHas(classes.essential, a))
+    return PRIME_YES;
+
+  /* Só em RHS: qualquer chave com a continua superchave sem ele */
+  if (attrsetHas(classes.rhsOnly, a))
+    return PRIME_NO;
+
+  /* Determinado pelos essenciais E (que estão em toda chave):
+     K \ {a} ⊇ E ainda determina a */
+  attrset essentialAttributes = classes.essential;
+  if (attrsetHas(indexedClosure(closureIndex, cache, essentialAttributes), a))
+    return PRIME_NO;
+
+  /* Busca dirigida: primeiro some com o que a ajuda a determinar
+     (sozinho com E, ou junto com o resto de cada LHS que o contém),
+     depois na ordem dos índices */
+  attrset helped = attrsetMinus(indexedClosure(closureIndex, cache, attrsetWith(essentialAttributes, a)),
+                                attrsetWith(essentialAttributes, a));
+  if (keyWithAttributeFound(U, U, essentialAttributes, closureIndex, cache, a, helped) ||
+      keyWithAttributeFound(U, U, essentialAttributes, closureIndex, cache, a, attrsetEmpty()))
+    return PRIME_YES;
+
+  /* Passos de Lucchesi–Osborn a partir de uma chave K: para cada
+     FD X -> Y com a ∈ X, a superchave X ∪ (K \ Y) contém a */
+  attrset K = minimizeSuperkey(U, U, essentialAttributes, closureIndex, cache);
+  int attempts = 0;
+  for (int i = 0; i < fdCount && attempts < KEYS_ORACLE_ATTEMPTS; ++i)
+  {
+    if (!attrsetHas(fds[i].lhs, a))
+      continue;
+
+    attempts++;
+    attrset S = attrsetIntersect(U, attrsetUnion(fds[i].lhs, attrsetMinus(K, fds[i].rhs)));
+    if (keyWithAttributeFound(U, S, essentialAttributes, closureIndex, cache, a, fds[i].rhs) ||
+        keyWithAttributeFound(U, U, essentialAttributes, closureIndex, cache, a, fds[i].rhs))
+      return PRIME_YES;
+  }
+
+  return PRIME_UNKNOWN;
+}
+
+static int compareKeys(const void *a, const void *b)
+{
+  return attrsetCompare(*(const attrset *)a, *(const attrset *)b);
+}
+
+/* ---------------------------------------------------------
+   Componentes independentes.
+
+   Duas FDs não triviais ficam no mesmo componente quando
+   compartilham atributos (fecho transitivo). Como nenhuma FD
+   atravessa componentes, o fecho de X é a união dos fechos de
+   X restrito a cada um: X é superchave sse cada parte é
+   superchave do seu componente, e é mínima sse cada parte é.
+   As chaves são então o produto cartesiano das chaves dos
+   componentes, unidas aos atributos fora de todos eles.
+--------------------------------------------------------- */
+typedef struct
+{
+  attrset attributes;
+  const FD *fds;
+  int fdCount;
+
+  attrset *keys;
+  int keyCount;
+} KeyComponent;
+
+static int findRoot(int *parent, int a)
+{
+  while (parent[a] != a)
+  {
+    parent[a] = parent[parent[a]];
+    a = parent[a];
+  }
+  return a;
+}
+
+/* Agrupa as FDs não triviais por componente em grouped (mesmo
+   tamanho de fds); retorna os componentes, ou NULL sem memória */
+static KeyComponent *splitComponents(attrset U, const FD *fds, int fdCount, FD *grouped,
+                                     int *outComponentCount)
+{
+  int parent[ATTRSET_MAX_ATTRS];
+  int componentOf[ATTRSET_MAX_ATTRS];
+  int attrLimit = activeAttrsetWords() * 64;
+
+  for (int a = 0; a < attrLimit; ++a)
+  {
+    parent[a] = a;
+    componentOf[a] = -1;
+  }
+
+  for (int i = 0; i < fdCount; ++i)
+  {
+    if (attrsetIsSubset(fds[i].rhs, fds[i].lhs))
+      continue;
+
+    attrset attributes = attrsetIntersect(U, attrsetUnion(fds[i].lhs, fds[i].rhs));
+    int first = attrsetNext(attributes, 0);
+    if (first < 0)
+      continue;
+
+    for (int a = attrsetNext(attributes, first + 1); a >= 0; a = attrsetNext(attributes, a + 1))
+      parent[findRoot(parent, a)] = findRoot(parent, first);
+  }
+
+  /* Numera os componentes e conta as FDs de cada um */
+  int componentCount = 0;
+  Arena *scratch = getScratchArena();
+  int *fdComponent = scratchAlloc(scratch, sizeof(int) * (fdCount > 0 ? fdCount : 1));
+  KeyComponent *components = scratchCalloc(scratch, fdCount > 0 ? fdCount : 1, sizeof(KeyComponent));
+  if (!fdComponent || !components)
+  {
+    scratchFree(scratch, fdComponent);
+    scratchFree(scratch, components);
+    return NULL;
+  }
+
+  for (int i = 0; i < fdCount; ++i)
+  {
+    fdComponent[i] = -1;
+    attrset attributes = attrsetIntersect(U, attrsetUnion(fds[i].lhs, fds[i].rhs));
+    if (attrsetIsSubset(fds[i].rhs, fds[i].lhs) || attrsetIsEmpty(attributes))
+      continue;
+
+    int root = findRoot(parent, attrsetNext(attributes, 0));
+    if (componentOf[root] < 0)
+      componentOf[root] = componentCount++;
+
+    KeyComponent *component = &components[componentOf[root]];
+    component->attributes = attrsetUnion(component->attributes, attributes);
+    component->fdCount++;
+    fdComponent[i] = componentOf[root];
+  }
+
+  /* Distribui as FDs em blocos contíguos */
+  int offset = 0;
+  for (int c = 0; c < componentCount; ++c)
+  {
+    components[c].fds = grouped + offset;
+    offset += components[c].fdCount;
+    components[c].fdCount = 0;
+  }
+  for (int i = 0; i < fdCount; ++i)
+  {
+    if (fdComponent[i] < 0)
+      continue;
+
+    KeyComponent *component = &components[fdComponent[i]];
+    grouped[component->fds - grouped + component->fdCount++] = fds[i];
+  }
+
+  scratchFree(scratch, fdComponent);
+  *outComponentCount = componentCount;
+  return components;
+}
+
+/* Chaves de (U, fds) com o algoritmo configurado, sem ordenar */
+static attrset *searchKeys(attrset U, const FD *fds, int fdCount, int threads, int *outCount)
+{
+  ClosureIndex *closureIndex = buildMergedClosureIndex(fds, fdCount);
+  if (!closureIndex)
+  {
+    *outCount = 0;
+    return NULL;
+  }
+
+  AttributeClasses classes = classifyAttributes(U, fds, fdCount);
+  attrset *candidateKeys;
+
+  if (currentAlgorithm == KEYS_ALGO_LO)
+    candidateKeys = lucchesiOsbornKeys(&classes, fds, fdCount, closureIndex, outCount);
+  else if (currentAlgorithm == KEYS_ALGO_DFS)
+    candidateKeys = dfsCandidateKeys(&classes, closureIndex, outCount);
+  else if (threads > 1)
+    candidateKeys = parallelBfsCandidateKeys(&classes, closureIndex, threads, outCount);
+  else
+    candidateKeys = bfsCandidateKeys(&classes, closureIndex, outCount);
+
+  freeClosureIndex(closureIndex);
+  return candidateKeys;
+}
+
+typedef struct
+{
+  KeyComponent *components;
+  int componentCount;
+  int next;
+  int attrWords;
+} ComponentQueue;
+
+/* Cada thread resolve componentes inteiros, na ordem da fila */
+static void *componentWorkerMain(void *arg)
+{
+  ComponentQueue *queue = arg;
+  attrsetUseWords(queue->attrWords);
+
+  for (;;)
+  {
+    int c = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+    if (c >= queue->componentCount)
+      return NULL;
+
+    KeyComponent *component = &queue->components[c];
+    component->keys = searchKeys(component->attributes, component->fds, component->fdCount, 1,
+                                 &component->keyCount);
+  }
+}
+
+static void solveComponents(KeyComponent *components, int componentCount, int threads)
+{
+  if (threads > componentCount)
+    threads = componentCount;
+
+  ComponentQueue queue = {components, componentCount, 0, activeAttrsetWords()};
+
+  pthread_t *workers = threads > 1 ? malloc(sizeof(pthread_t) * threads) : NULL;
+  int started = 0;
+  while (workers && started < threads &&
+         pthread_create(&workers[started], NULL, componentWorkerMain, &queue) == 0)
+    started++;
+
+  /* A thread atual também trabalha (e cobre a falta de threads) */
+  componentWorkerMain(&queue);
+
+  for (int t = 0; t < started; ++t)
+    pthread_join(workers[t], NULL);
+  free(workers);
+}
+
+/* Produto cartesiano das chaves dos componentes, cada uma unida a base.
+   NULL (com o erro em stderr) se algum componente falhou, se o produto
+   não cabe num int ou sem memória. */
+static attrset *combineComponentKeys(attrset base, const KeyComponent *components, int componentCount,
+                                     int *outCount)
+{
+  long total = 1;
+  for (int c = 0; c < componentCount; ++c)
+  {
+    if (!components[c].keys || components[c].keyCount == 0)
+    {
+      fprintf(stderr, "Error: out of memory enumerating keys\n");
+      return NULL;
+    }
+
+    total *= components[c].keyCount;
+    if (total > INT_MAX)
+    {
+      fprintf(stderr, "Error: too many candidate keys\n");
+      return NULL;
+    }
+  }
+
+  attrset *keys = malloc(sizeof(attrset) * total);
+  if (!keys)
+  {
+    fprintf(stderr, "Error: out of memory enumerating keys\n");
+    return NULL;
+  }
+
+  /* Cada chave é um número misto: um dígito por componente */
+  for (long k = 0; k < total; ++k)
+  {
+    attrset key = base;
+    long rest = k;
+    for (int c = componentCount - 1; c >= 0; --c)
+    {
+      key = attrsetUnion(key, components[c].keys[rest % components[c].keyCount]);
+      rest /= components[c].keyCount;
+    }
+    keys[k] = key;
+  }
+
+  *outCount = (int)total;
+  return keys;
+}
+
+attrset *computeCandidateKeys(attrset U, const FD *fds, int fdCount, int *outCount)
+{
+  STATS_PHASE_BEGIN(timer);
+
+  /* FDs agrupadas e componentes vêm da arena de rascunho, se houver */
+  Arena *scratch = getScratchArena();
+  int componentCount = 0;
+  FD *grouped = scratchAlloc(scratch, sizeof(FD) * (fdCount > 0 ? fdCount : 1));
+  KeyComponent *components = grouped ? splitComponents(U, fds, fdCount, grouped, &componentCount) : NULL;
+  if (!components)
+  {
+    fprintf(stderr, "Error: out of memory enumerating keys\n");
+    scratchFree(scratch, grouped);
+    *outCount = 0;
+    STATS_PHASE_END(STAT_PHASE_KEYS, timer);
+    return NULL;
+  }
+
+  int keyCount = 0;
+  attrset *candidateKeys;
+
+  if (componentCount <= 1)
+  {
+    /* Um componente só: a BFS paralela reparte a busca dele */
+    candidateKeys = searchKeys(U, fds, fdCount, currentThreads, &keyCount);
+    if (!candidateKeys)
+      fprintf(stderr, "Error: out of memory enumerating keys\n");
+  }
+  else
+  {
+    solveComponents(components, componentCount, currentThreads);
+
+    attrset outside = U;
+    for (int c = 0; c < componentCount; ++c)
+      outside = attrsetMinus(outside, components[c].attributes);
+
+    candidateKeys = combineComponentKeys(outside, components, componentCount, &keyCount);
+  }
+
+  for (int c = 0; c < componentCount; ++c)
+    free(components[c].keys);
+  scratchFree(scratch, components);
+  scratchFree(scratch, grouped);
+
+  /* Toda relação tem ao menos uma chave: sem nenhuma, a busca falhou */
+  if (!candidateKeys || keyCount == 0)
   {
     free(candidateKeys);
     *outCount = 0;
+    STATS_PHASE_END(STAT_PHASE_KEYS, timer);
     return NULL;
   }
 
+  /* Ordem determinística: por tamanho, depois lexicográfica */
+  qsort(candidateKeys, keyCount, sizeof(attrset), compareKeys);
+
   /* Ajusta tamanho final */
   candidateKeys = realloc(candidateKeys, sizeof(attrset) * keyCount);
   *outCount = keyCount;
+  STATS_PHASE_END(STAT_PHASE_KEYS, timer);
 
   return candidateKeys;
 }
+
+KeyEnumStatus enumerateCandidateKeys(attrset U, const FD *fds, int fdCount, const KeyLimits *limits,
+                                     KeyCallback callback, void *context, long *outCount)
+{
+  *outCount = 0;
+
+  ClosureIndex *closureIndex = buildMergedClosureIndex(fds, fdCount);
+  if (!closureIndex)
+    return KEYS_FAILED;
+
+  STATS_PHASE_BEGIN(timer);
+  AttributeClasses classes = classifyAttributes(U, fds, fdCount);
+  KeyEnumStatus status = dfsEnumerateKeys(&classes, closureIndex, limits, callback, context, outCount);
+  STATS_PHASE_END(STAT_PHASE_KEYS, timer);
+
+  freeClosureIndex(closureIndex);
+  return status;
+}
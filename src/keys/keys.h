@@ -3,7 +3,71 @@
 
 #include <stdint.h>
 #include "parser.h"
+#include "closure.h"
+#include "closurecache.h"
 
-attrset *computeCandidateKeys(attrset U, FD *fds, int fdCount, int *outCount);
+/* Algoritmo de enumeração de chaves:
+     BFS — busca em largura sobre os superconjuntos dos atributos essenciais
+     LO  — Lucchesi–Osborn, polinomial no número de chaves
+     DFS — busca em profundidade, memória proporcional à profundidade */
+typedef enum
+{
+  KEYS_ALGO_BFS,
+  KEYS_ALGO_LO,
+  KEYS_ALGO_DFS
+} KeyAlgorithm;
+
+void setKeyAlgorithm(KeyAlgorithm algorithm);
+KeyAlgorithm getKeyAlgorithm(void);
+
+/* Threads da BFS (1 = serial; 0 = uma por CPU disponível) */
+void setKeyThreads(int threads);
+int getKeyThreads(void);
+
+/* Chaves candidatas em ordem determinística (tamanho, depois lexicográfica).
+   NULL, com o erro em stderr, sem memória ou com chaves demais para um
+   vetor (produto das chaves de componentes independentes). */
+attrset *computeCandidateKeys(attrset U, const FD *fds, int fdCount, int *outCount);
+
+/* Enumeração em fluxo (DFS): cada chave é entregue ao callback assim que
+   sua minimalidade é confirmada, na ordem da busca. Nenhuma chave é
+   guardada: a memória é proporcional a |U|. O callback retorna != 0
+   para interromper. */
+typedef int (*KeyCallback)(attrset key, void *context);
+
+// Limites da enumeração (0 = sem limite)
+typedef struct
+{
+  long maxKeys;
+  double timeBudget; // segundos
+} KeyLimits;
+
+typedef enum
+{
+  KEYS_COMPLETE,   // todas as chaves foram entregues
+  KEYS_KEY_LIMIT,  // parou em maxKeys
+  KEYS_TIME_LIMIT, // parou por tempo
+  KEYS_STOPPED,    // o callback pediu para parar
+  KEYS_FAILED = -1 // sem memória
+} KeyEnumStatus;
+
+KeyEnumStatus enumerateCandidateKeys(attrset U, const FD *fds, int fdCount, const KeyLimits *limits,
+                                     KeyCallback callback, void *context, long *outCount);
+
+/* Oráculo "a está em alguma chave candidata?", sem enumerar as chaves:
+   certificados baratos (a fora de todo RHS; a só em RHS; a determinado
+   pelos atributos essenciais) e uma busca dirigida por uma chave que
+   contenha a. UNKNOWN quando nada decide: aí só a enumeração responde.
+   closureIndex deve ser um índice sobre fds. cache (pode ser NULL) guarda
+   os fechos entre chamadas: as buscas de atributos diferentes se repetem. */
+typedef enum
+{
+  PRIME_NO = 0,
+  PRIME_YES = 1,
+  PRIME_UNKNOWN = -1
+} PrimeVerdict;
+
+PrimeVerdict primeAttributeOracle(attrset U, const FD *fds, int fdCount, ClosureIndex *closureIndex,
+                                  ClosureCache *cache, int a);
 
 #endif
\ No newline at end of file
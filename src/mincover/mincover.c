@@ -1,8 +1,73 @@
 #include "mincover.h"
 #include "closure.h"
+#include "stats.h"
+#include "arena.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+
+static int currentThreads = 1;
+
+/* FDs testadas especulativamente por thread em cada janela do passo 3 */
+#define MINCOVER_WINDOW_PER_THREAD 512
+
+void setMinCoverThreads(int threads)
+{
+  if (threads <= 0)
+  {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (int)online : 1;
+  }
+  currentThreads = threads;
+}
+
+int getMinCoverThreads(void)
+{
+  return currentThreads;
+}
+
+/* -----------------------------------------------------------------------------
+   Execução paralela: cada tarefa roda numa thread, com a largura de
+   conjuntos da chamadora; se a criação falhar, a tarefa roda na própria
+   thread chamadora.
+ ----------------------------------------------------------------------------- */
+typedef struct
+{
+  void *(*taskMain)(void *);
+  void *task;
+  int attrWords;
+} TaskStart;
+
+static void *taskStart(void *arg)
+{
+  TaskStart *start = arg;
+  attrsetUseWords(start->attrWords);
+  return start->taskMain(start->task);
+}
+
+static void runTasks(void *(*taskMain)(void *), void *tasks, size_t taskSize, int taskCount)
+{
+  pthread_t threads[taskCount];
+  TaskStart starts[taskCount];
+  char started[taskCount];
+
+  for (int t = 0; t < taskCount; ++t)
+  {
+    void *task = (char *)tasks + (size_t)t * taskSize;
+    starts[t].taskMain = taskMain;
+    starts[t].task = task;
+    starts[t].attrWords = activeAttrsetWords();
+    started[t] = pthread_create(&threads[t], NULL, taskStart, &starts[t]) == 0;
+    if (!started[t])
+      taskMain(task);
+  }
+
+  for (int t = 0; t < taskCount; ++t)
+    if (started[t])
+      pthread_join(threads[t], NULL);
+}
 
 /* -----------------------------------------------------------------------------
    PASSO 1 — Decompor o lado direito (RHS)
@@ -12,15 +77,13 @@
        X -> C
    Isso garante que cada FD tenha apenas 1 atributo no RHS.
  ----------------------------------------------------------------------------- */
-static FD *decomposeRhs(FD *fds, int fdCount, int *outCount)
+static FD *decomposeRhs(Arena *scratch, FD *fds, int fdCount, int *outCount)
 {
   int rhsAtomCount = 0;
 
   /* Conta quantos atributos individuais existem no RHS de todas as FDs */
   for (int i = 0; i < fdCount; ++i)
-    for (int b = 0; b < 26; ++b)
-      if (fds[i].rhs & (1u << b))
-        rhsAtomCount++;
+    rhsAtomCount += attrsetCount(fds[i].rhs);
 
   if (rhsAtomCount == 0)
   {
@@ -29,7 +92,7 @@ static FD *decomposeRhs(FD *fds, int fdCount, int *outCount)
   }
 
   /* Aloca espaço para todas as dependências unitárias */
-  FD *unitaryFds = malloc(sizeof(FD) * rhsAtomCount);
+  FD *unitaryFds = scratchAlloc(scratch, sizeof(FD) * rhsAtomCount);
   if (!unitaryFds)
   {
     *outCount = 0;
@@ -41,14 +104,12 @@ static FD *decomposeRhs(FD *fds, int fdCount, int *outCount)
   /* Cria as dependências X -> A, X -> B, X -> C... */
   for (int i = 0; i < fdCount; ++i)
   {
-    for (int b = 0; b < 26; ++b)
+    attrset rhs = fds[i].rhs;
+    for (int b = attrsetNext(rhs, 0); b >= 0; b = attrsetNext(rhs, b + 1))
     {
-      if (fds[i].rhs & (1u << b))
-      {
-        unitaryFds[index].lhs = fds[i].lhs;
-        unitaryFds[index].rhs = (1u << b);
-        index++;
-      }
+      unitaryFds[index].lhs = fds[i].lhs;
+      unitaryFds[index].rhs = attrsetSingleton(b);
+      index++;
     }
   }
 
@@ -57,81 +118,220 @@ static FD *decomposeRhs(FD *fds, int fdCount, int *outCount)
 }
 
 /* -----------------------------------------------------------------------------
-   PASSO 2 — Verificar se um atributo do LHS é estranho (redundante)
+   PASSO 2 — Remover atributos estranhos (redundantes) do LHS
    Um atributo é estranho se, ao removê-lo, o fecho ainda determinar o RHS.
+   O índice foi construído sobre as FDs unitárias originais (em FdTable, com
+   LHS iguais juntados): cada redução de LHS produz um conjunto equivalente,
+   logo o fecho não muda e o índice não precisa ser refeito.
+
+   Os testes são feitos em rodadas, com os fechos calculados em lote: para
+   cada FD pendente, testa de uma vez todos os seus candidatos contra o LHS
+   atual. O primeiro atributo estranho é exatamente o que a varredura
+   sequencial removeria; os testes seguintes ficam invalidados pela remoção
+   e a FD volta na próxima rodada.
+
+   Os resultados negativos são reaproveitados: se a não é estranho em L,
+   também não é em L' ⊆ L (o fecho de L' \ {a} está contido no de L \ {a}).
+   Por isso uma só passada basta, e na rodada seguinte só voltam como
+   candidatos os atributos depois do removido que passaram no teste.
  ----------------------------------------------------------------------------- */
-static int lhsAttributeIsRedundant(FD *fdSet, int fdCount, int targetIndex, int bit)
+static int removeExtraneousAttributes(FD *fdSet, int fdCount, const ClosureIndex *index)
 {
-  attrset originalLhs = fdSet[targetIndex].lhs;
+  Arena *scratch = getScratchArena();
+  int *pending = scratchAlloc(scratch, sizeof(int) * fdCount);
+  attrset *candidates = scratchAlloc(scratch, sizeof(attrset) * fdCount);
+
+  int pendingCount = 0;
+  size_t queryCapacity = 0;
 
   /* Não pode reduzir se só há um atributo no LHS */
-  if (__builtin_popcount(originalLhs) <= 1)
-    return 0;
+  for (int i = 0; i < fdCount && pending && candidates; ++i)
+  {
+    int lhsSize = attrsetCount(fdSet[i].lhs);
+    if (lhsSize <= 1)
+      continue;
 
-  /* Remove o atributo candidato e calcula fecho */
-  attrset reducedLhs = originalLhs & ~(1u << bit);
-  attrset closure = reducedLhs;
+    pending[pendingCount++] = i;
+    candidates[i] = fdSet[i].lhs;
+    queryCapacity += lhsSize;
+  }
+
+  attrset *queries = scratchAlloc(scratch, sizeof(attrset) * (queryCapacity ? queryCapacity : 1));
+  attrset *closures = scratchAlloc(scratch, sizeof(attrset) * (queryCapacity ? queryCapacity : 1));
 
-  int changed = 1;
-  while (changed)
+  if (!pending || !candidates || !queries || !closures)
   {
-    changed = 0;
+    scratchFree(scratch, pending);
+    scratchFree(scratch, candidates);
+    scratchFree(scratch, queries);
+    scratchFree(scratch, closures);
+    return -1;
+  }
 
-    for (int i = 0; i < fdCount; ++i)
+  while (pendingCount > 0)
+  {
+    /* Um teste por candidato de cada FD pendente */
+    int queryCount = 0;
+    for (int p = 0; p < pendingCount; ++p)
     {
-      attrset lhs = fdSet[i].lhs;
+      int i = pending[p];
+      for (int b = attrsetNext(candidates[i], 0); b >= 0; b = attrsetNext(candidates[i], b + 1))
+        queries[queryCount++] = attrsetWithout(fdSet[i].lhs, b);
+    }
+
+    STATS_COUNT(STAT_EXTRANEOUS_TESTS, queryCount);
+    computeClosureBatchParallel(index, queries, closures, queryCount, currentThreads);
 
-      if ((closure & lhs) == lhs)
+    int query = 0, nextPendingCount = 0;
+    for (int p = 0; p < pendingCount; ++p)
+    {
+      int i = pending[p];
+      attrset tested = candidates[i];
+      int removed = -1;
+
+      for (int b = attrsetNext(tested, 0); b >= 0; b = attrsetNext(tested, b + 1), ++query)
       {
-        attrset newAttributes = fdSet[i].rhs & ~closure;
-        if (newAttributes)
-        {
-          closure |= newAttributes;
-          changed = 1;
-        }
+        /* Se o fecho ainda determina o RHS, o atributo é estranho */
+        if (!attrsetIsSubset(fdSet[i].rhs, closures[query]))
+          attrsetErase(&candidates[i], b);
+        else if (removed < 0)
+          removed = b;
       }
+
+      if (removed < 0)
+        continue;
+
+      /* Antes do removido todos falharam; depois dele, os que passaram
+         precisam ser testados de novo contra o LHS reduzido */
+      attrsetErase(&fdSet[i].lhs, removed);
+      for (int b = attrsetNext(candidates[i], 0); b >= 0 && b <= removed; b = attrsetNext(candidates[i], b + 1))
+        attrsetErase(&candidates[i], b);
+
+      if (attrsetCount(fdSet[i].lhs) > 1 && !attrsetIsEmpty(candidates[i]))
+        pending[nextPendingCount++] = i;
     }
+
+    pendingCount = nextPendingCount;
   }
 
-  /* Se o fecho ainda determina o RHS, o atributo é estranho */
-  return (closure & fdSet[targetIndex].rhs) == fdSet[targetIndex].rhs;
+  scratchFree(scratch, pending);
+  scratchFree(scratch, candidates);
+  scratchFree(scratch, queries);
+  scratchFree(scratch, closures);
+  return 0;
 }
 
 /* -----------------------------------------------------------------------------
    PASSO 3 — Verificar se uma FD é redundante
    Testa se X -> A pode ser removida sem alterar o conjunto de implicações.
-   Usa a máscara "keepMask" para ignorar dependências já removidas.
+   As dependências já removidas saíram do índice; a FD testada é desativada
+   temporariamente.
+ ----------------------------------------------------------------------------- */
+static int fdIsRedundant(FD *fdSet, ClosureIndex *index, int targetIndex)
+{
+  STATS_COUNT(STAT_REDUNDANCY_TESTS, 1);
+  setClosureIndexFd(index, targetIndex, 0);
+
+  /* Se o fecho obtiver o RHS, então a FD era redundante; o fecho para
+     assim que o alcança */
+  int redundant = closureImplies(index, fdSet[targetIndex].lhs, fdSet[targetIndex].rhs);
+
+  /* Redundante: sai das listas do índice, e as consultas seguintes nem a
+     visitam. Senão, volta a valer. */
+  if (redundant)
+    removeClosureIndexFd(index, targetIndex);
+  else
+    setClosureIndexFd(index, targetIndex, 1);
+
+  return redundant;
+}
+
+/* -----------------------------------------------------------------------------
+   PASSO 3 em paralelo — verificação especulativa
+   As FDs são processadas em janelas. Dentro de uma janela, cada FD é testada
+   em paralelo contra o estado do início da janela (sem as FDs removidas até
+   ali, e ignorando a própria FD). Depois as decisões são confirmadas em
+   ordem:
+     - "não redundante" continua valendo: remoções posteriores só diminuem
+       os fechos;
+     - "redundante" vale se nenhuma FD anterior da janela foi removida;
+       senão, é testada de novo contra o estado atual.
+   O resultado é o mesmo da execução serial.
  ----------------------------------------------------------------------------- */
-static int fdIsRedundant(FD *fdSet, int fdCount, int targetIndex, const char *keepMask)
+typedef struct
+{
+  const ClosureIndex *index;
+  const FD *fdSet;
+  ClosureScratch scratch;
+  char *verdict;
+  int begin;
+  int end;
+} RedundancyTask;
+
+static void *redundancyTaskMain(void *arg)
+{
+  RedundancyTask *task = arg;
+  STATS_COUNT(STAT_REDUNDANCY_TESTS, task->end - task->begin);
+  for (int i = task->begin; i < task->end; ++i)
+    task->verdict[i] = (char)closureImpliesWithScratch(task->index, &task->scratch, task->fdSet[i].lhs,
+                                                       task->fdSet[i].rhs, i);
+  return NULL;
+}
+
+static int removeRedundantFdsParallel(FD *fdSet, int fdCount, ClosureIndex *index, char *keepMask)
 {
-  attrset closure = fdSet[targetIndex].lhs;
+  int taskCount = currentThreads;
+  RedundancyTask tasks[taskCount];
+  Arena *scratch = getScratchArena();
+  char *verdict = scratchAlloc(scratch, fdCount);
+  int failed = verdict == NULL;
+
+  int initialized = 0;
+  for (; initialized < taskCount && !failed; ++initialized)
+  {
+    tasks[initialized].index = index;
+    tasks[initialized].fdSet = fdSet;
+    tasks[initialized].verdict = verdict;
+    if (initClosureScratch(&tasks[initialized].scratch, index) != 0)
+      failed = 1;
+  }
 
-  int changed = 1;
-  while (changed)
+  int window = taskCount * MINCOVER_WINDOW_PER_THREAD;
+  for (int start = 0; start < fdCount && !failed; start += window)
   {
-    changed = 0;
+    int end = fdCount - start < window ? fdCount : start + window;
 
-    for (int j = 0; j < fdCount; ++j)
+    for (int t = 0; t < taskCount; ++t)
     {
-      if (j == targetIndex)
-        continue;
-      if (!keepMask[j])
+      tasks[t].begin = start + (int)((long long)(end - start) * t / taskCount);
+      tasks[t].end = start + (int)((long long)(end - start) * (t + 1) / taskCount);
+    }
+    runTasks(redundancyTaskMain, tasks, sizeof(RedundancyTask), taskCount);
+
+    /* Confirma em ordem */
+    int removedInWindow = 0;
+    for (int i = start; i < end; ++i)
+    {
+      if (!verdict[i])
         continue;
 
-      if ((closure & fdSet[j].lhs) == fdSet[j].lhs)
+      if (removedInWindow)
       {
-        attrset newAttributes = fdSet[j].rhs & ~closure;
-        if (newAttributes)
-        {
-          closure |= newAttributes;
-          changed = 1;
-        }
+        if (!fdIsRedundant(fdSet, index, i))
+          continue;
       }
+      else
+        removeClosureIndexFd(index, i);
+
+      keepMask[i] = 0;
+      removedInWindow = 1;
     }
   }
 
-  /* Se o fecho obtiver o RHS, então a FD era redundante */
-  return (closure & fdSet[targetIndex].rhs) == fdSet[targetIndex].rhs;
+  for (int t = 0; t < initialized; ++t)
+    freeClosureScratch(&tasks[t].scratch);
+  scratchFree(scratch, verdict);
+  return failed ? -1 : 0;
 }
 
 /* -----------------------------------------------------------------------------
@@ -142,48 +342,60 @@ static int fdIsRedundant(FD *fdSet, int fdCount, int targetIndex, const char *ke
  ----------------------------------------------------------------------------- */
 FD *computeMinimumCover(FD *fds, int fdCount, int *outCount)
 {
+  /* Vetores intermediários vêm da arena de rascunho, se houver */
+  Arena *scratch = getScratchArena();
+
   /* 1) Decompor RHS */
   int unitaryCount = 0;
-  FD *unitaryFds = decomposeRhs(fds, fdCount, &unitaryCount);
+  STATS_PHASE_BEGIN(decomposeTimer);
+  FD *unitaryFds = decomposeRhs(scratch, fds, fdCount, &unitaryCount);
+  STATS_PHASE_END(STAT_PHASE_DECOMPOSE, decomposeTimer);
 
   if (unitaryCount == 0 || unitaryFds == NULL)
   {
     *outCount = 0;
-    if (unitaryFds)
-      free(unitaryFds);
+    scratchFree(scratch, unitaryFds);
     return NULL;
   }
 
-  /* 2) Remover atributos estranhos do LHS */
-  int changed = 1;
-  while (changed)
+  ClosureIndex *closureIndex = buildMergedClosureIndex(unitaryFds, unitaryCount);
+  if (!closureIndex)
   {
-    changed = 0;
+    scratchFree(scratch, unitaryFds);
+    *outCount = 0;
+    return NULL;
+  }
 
-    for (int i = 0; i < unitaryCount; ++i)
-    {
-      attrset lhs = unitaryFds[i].lhs;
+  /* 2) Remover atributos estranhos do LHS */
+  STATS_PHASE_BEGIN(extraneousTimer);
+  int extraneousStatus = removeExtraneousAttributes(unitaryFds, unitaryCount, closureIndex);
+  STATS_PHASE_END(STAT_PHASE_EXTRANEOUS, extraneousTimer);
+  if (extraneousStatus != 0)
+  {
+    freeClosureIndex(closureIndex);
+    scratchFree(scratch, unitaryFds);
+    *outCount = 0;
+    return NULL;
+  }
 
-      for (int b = 0; b < 26; ++b)
-      {
-        if (lhs & (1u << b))
-        {
-          if (lhsAttributeIsRedundant(unitaryFds, unitaryCount, i, b))
-          {
-            unitaryFds[i].lhs &= ~(1u << b);
-            changed = 1;
-            lhs = unitaryFds[i].lhs;
-          }
-        }
-      }
-    }
+  /* 3) Remover dependências redundantes
+        Aqui cada teste retira uma FD do conjunto, e o resultado passa a
+        depender dos LHS reduzidos: o índice é reconstruído a partir deles,
+        uma posição por FD unitária, para poder desativá-las uma a uma. */
+  freeClosureIndex(closureIndex);
+  closureIndex = buildClosureIndex(unitaryFds, unitaryCount);
+  if (!closureIndex)
+  {
+    scratchFree(scratch, unitaryFds);
+    *outCount = 0;
+    return NULL;
   }
 
-  /* 3) Remover dependências redundantes */
-  char *keepMask = malloc(unitaryCount);
+  char *keepMask = scratchAlloc(scratch, unitaryCount);
   if (!keepMask)
   {
-    free(unitaryFds);
+    freeClosureIndex(closureIndex);
+    scratchFree(scratch, unitaryFds);
     *outCount = 0;
     return NULL;
   }
@@ -191,13 +403,30 @@ FD *computeMinimumCover(FD *fds, int fdCount, int *outCount)
   for (int i = 0; i < unitaryCount; ++i)
     keepMask[i] = 1;
 
-  for (int i = 0; i < unitaryCount; ++i)
+  STATS_PHASE_BEGIN(redundantTimer);
+  int redundantStatus = 0;
+  if (currentThreads > 1)
+    redundantStatus = removeRedundantFdsParallel(unitaryFds, unitaryCount, closureIndex, keepMask);
+  else
   {
-    if (!keepMask[i])
-      continue;
+    for (int i = 0; i < unitaryCount; ++i)
+    {
+      if (!keepMask[i])
+        continue;
 
-    if (fdIsRedundant(unitaryFds, unitaryCount, i, keepMask))
-      keepMask[i] = 0;
+      if (fdIsRedundant(unitaryFds, closureIndex, i))
+        keepMask[i] = 0;
+    }
+  }
+  STATS_PHASE_END(STAT_PHASE_REDUNDANT, redundantTimer);
+
+  if (redundantStatus != 0)
+  {
+    freeClosureIndex(closureIndex);
+    scratchFree(scratch, unitaryFds);
+    scratchFree(scratch, keepMask);
+    *outCount = 0;
+    return NULL;
   }
 
   /* Conta quantas dependências restaram */
@@ -209,8 +438,9 @@ FD *computeMinimumCover(FD *fds, int fdCount, int *outCount)
   FD *result = malloc(sizeof(FD) * keptCount);
   if (!result)
   {
-    free(unitaryFds);
-    free(keepMask);
+    freeClosureIndex(closureIndex);
+    scratchFree(scratch, unitaryFds);
+    scratchFree(scratch, keepMask);
     *outCount = 0;
     return NULL;
   }
@@ -223,8 +453,9 @@ FD *computeMinimumCover(FD *fds, int fdCount, int *outCount)
       result[index++] = unitaryFds[i];
   }
 
-  free(unitaryFds);
-  free(keepMask);
+  freeClosureIndex(closureIndex);
+  scratchFree(scratch, unitaryFds);
+  scratchFree(scratch, keepMask);
 
   *outCount = keptCount;
   return result;
@@ -3,6 +3,11 @@
 
 #include "parser.h"
 
+/* Threads do cálculo (1 = serial; 0 = uma por CPU disponível). O resultado
+   é o mesmo da execução serial. */
+void setMinCoverThreads(int threads);
+int getMinCoverThreads(void);
+
 FD *computeMinimumCover(FD *fds, int fdCount, int *outCount);
 
 #endif
\ No newline at end of file
@@ -1,144 +1,208 @@
 #include "normalform.h"
-#include "mincover.h"
-#include "keys.h"
-#include "closure.h"
+#include "stats.h"
+#include "arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 // Verifica se A está contido em B  (A ⊆ B)
 static int isSubset(attrset subset, attrset superset)
 {
-  return (subset & superset) == subset;
+  return attrsetIsSubset(subset, superset);
 }
 
-// Imprime um conjunto de atributos (bitmask -> ABC...)
-static void printAttrset(attrset set)
+/* Veredicto de uma FD da cobertura: calculado uma vez e reduzido às
+   flags de BCNF e 3NF por classifyNormalForms */
+typedef struct
 {
-  for (int i = 0; i < 26; ++i)
-    if (set & (1u << i))
-      putchar('A' + i);
+  char trivial;       // RHS ⊆ LHS: ignorada
+  char lhsIsSuperkey; // U ⊆ LHS+
+  char rhsIsPrime;    // RHS só tem atributos primos (só consultado se não é
+                      // trivial nem superchave)
+} FdVerdict;
+
+static int violatesBcnf(const FdVerdict *verdict)
+{
+  return !verdict->trivial && !verdict->lhsIsSuperkey;
+}
+
+static int violates3nf(const FdVerdict *verdict)
+{
+  return !verdict->trivial && !verdict->lhsIsSuperkey && !verdict->rhsIsPrime;
+}
+
+/* Os fechos dos LHS vêm do contexto, calculados em lote (e em paralelo,
+   com --threads); aqui só se derivam as flags. Só os RHS das FDs cujo LHS
+   não é superchave precisam ser classificados, e cada atributo é
+   perguntado ao oráculo de primos, sem enumerar as chaves. */
+static FdVerdict *buildVerdictTable(AnalysisContext *ctx, const FD *minCover, int minCount)
+{
+  const attrset *lhsClosures = analysisLhsClosures(ctx);
+  if (!lhsClosures || analysisFailed(ctx))
+    return NULL;
+
+  FdVerdict *verdicts = scratchAlloc(getScratchArena(), sizeof(FdVerdict) * minCount);
+  if (!verdicts)
+    return NULL;
+
+  for (int i = 0; i < minCount; ++i)
+  {
+    verdicts[i].trivial = (char)isSubset(minCover[i].rhs, minCover[i].lhs);
+    verdicts[i].lhsIsSuperkey = (char)isSubset(ctx->U, lhsClosures[i]);
+    verdicts[i].rhsIsPrime = 1;
+
+    if (verdicts[i].trivial || verdicts[i].lhsIsSuperkey)
+      continue;
+
+    attrset rhs = minCover[i].rhs;
+    for (int a = attrsetNext(rhs, 0); a >= 0 && verdicts[i].rhsIsPrime; a = attrsetNext(rhs, a + 1))
+      verdicts[i].rhsIsPrime = (char)analysisIsPrime(ctx, a);
+  }
+
+  if (analysisFailed(ctx))
+  {
+    scratchFree(getScratchArena(), verdicts);
+    return NULL;
+  }
+
+  return verdicts;
 }
 
 // Verificação das Formas Normais (BCNF e 3NF)
-void checkNormalForms(attrset U, FD *fds, int fdCount)
+void checkNormalForms(const AttrDict *dict, attrset U, FD *fds, int fdCount)
+{
+  AnalysisContext ctx;
+  initAnalysisContext(&ctx, U, fds, fdCount);
+  printNormalForms(dict, &ctx);
+  freeAnalysisContext(&ctx);
+}
+
+void printNormalForms(const AttrDict *dict, AnalysisContext *ctx)
+{
+  fprintNormalForms(stdout, dict, ctx);
+}
+
+/* Contagem e, se pedidas, flags por FD da cobertura (NULL = só contar) */
+static int classifyNormalForms(AnalysisContext *ctx, int *bcnfViolations, int *nf3Violations,
+                               char *violatesBcnfOut, char *violates3nfOut)
+{
+  int minCount = 0;
+  const FD *minCover = analysisCover(ctx, &minCount);
+  *bcnfViolations = 0;
+  *nf3Violations = 0;
+  if (minCount == 0)
+    return analysisFailed(ctx) ? -1 : 0;
+
+  STATS_PHASE_BEGIN(timer);
+  FdVerdict *verdicts = buildVerdictTable(ctx, minCover, minCount);
+  STATS_PHASE_END(STAT_PHASE_NORMALFORM, timer);
+  if (!verdicts)
+    return -1;
+
+  for (int i = 0; i < minCount; ++i)
+  {
+    int bcnf = violatesBcnf(&verdicts[i]);
+    int nf3 = violates3nf(&verdicts[i]);
+    *bcnfViolations += bcnf;
+    *nf3Violations += nf3;
+    if (violatesBcnfOut)
+      violatesBcnfOut[i] = (char)bcnf;
+    if (violates3nfOut)
+      violates3nfOut[i] = (char)nf3;
+  }
+
+  scratchFree(getScratchArena(), verdicts);
+  return 0;
+}
+
+int countNormalFormViolations(AnalysisContext *ctx, int *bcnfViolations, int *nf3Violations)
+{
+  return classifyNormalForms(ctx, bcnfViolations, nf3Violations, NULL, NULL);
+}
+
+int markNormalFormViolations(AnalysisContext *ctx, char *violatesBcnfOut, char *violates3nfOut)
+{
+  int bcnfViolations, nf3Violations;
+  return classifyNormalForms(ctx, &bcnfViolations, &nf3Violations, violatesBcnfOut, violates3nfOut);
+}
+
+void fprintNormalForms(FILE *out, const AttrDict *dict, AnalysisContext *ctx)
 {
   /* ---------------------------------------------------------
      1) Gerar a cobertura mínima
   --------------------------------------------------------- */
   int minCount = 0;
-  FD *minCover = computeMinimumCover(fds, fdCount, &minCount);
+  const FD *minCover = analysisCover(ctx, &minCount);
 
   if (minCount == 0)
   {
-    printf("No functional dependencies given.\nBCNF: OK\n3NF: OK\n");
+    fprintf(out, "No functional dependencies given.\nBCNF: OK\n3NF: OK\n");
     return;
   }
 
   /* ---------------------------------------------------------
-     2) Encontrar as chaves e os atributos primos
+     2) Flags e contagem das violações de BCNF e 3NF, da mesma
+        tabela de veredictos que a contagem usa
   --------------------------------------------------------- */
-  int keyCount = 0;
-  attrset *candidateKeys = computeCandidateKeys(U, minCover, minCount, &keyCount);
-
-  attrset primeAttributes = 0;
-  for (int i = 0; i < keyCount; ++i)
-    primeAttributes |= candidateKeys[i];
+  Arena *scratch = getScratchArena();
+  char *bcnfFlags = scratchAlloc(scratch, (size_t)minCount);
+  char *nf3Flags = scratchAlloc(scratch, (size_t)minCount);
+  int bcnfViolations = 0, nf3Violations = 0;
 
-  /* ---------------------------------------------------------
-     3) Detectar violações de BCNF e 3NF
-  --------------------------------------------------------- */
-  int bcnfOk = 1, bcnfViolations = 0;
-  int nf3Ok = 1, nf3Violations = 0;
-
-  for (int i = 0; i < minCount; ++i)
+  if (!bcnfFlags || !nf3Flags ||
+      classifyNormalForms(ctx, &bcnfViolations, &nf3Violations, bcnfFlags, nf3Flags) != 0)
   {
-    attrset lhs = minCover[i].lhs;
-    attrset rhs = minCover[i].rhs;
-
-    /* Ignora dependências triviais */
-    if (isSubset(rhs, lhs))
-      continue;
-
-    attrset lhsClosure = computeClosure(lhs, minCover, minCount);
-    int lhsIsSuperkey = isSubset(U, lhsClosure);
-    int rhsIsPrime = isSubset(rhs, primeAttributes);
-
-    if (!lhsIsSuperkey)
-    {
-      bcnfOk = 0;
-      bcnfViolations++;
-    }
-    if (!lhsIsSuperkey && !rhsIsPrime)
-    {
-      nf3Ok = 0;
-      nf3Violations++;
-    }
+    fprintf(stderr, "Error: out of memory\n");
+    scratchFree(scratch, nf3Flags);
+    scratchFree(scratch, bcnfFlags);
+    return;
   }
 
   /* ---------------------------------------------------------
-     4) Impressão das violações de BCNF
+     3) Impressão das violações de BCNF
   --------------------------------------------------------- */
-  if (bcnfOk)
+  if (bcnfViolations == 0)
   {
-    printf("BCNF: OK\n");
+    fprintf(out, "BCNF: OK\n");
   }
   else
   {
-    printf("BCNF: Violations (%d)\n", bcnfViolations);
+    fprintf(out, "BCNF: Violations (%d)\n", bcnfViolations);
 
     for (int i = 0; i < minCount; ++i)
     {
-      attrset lhs = minCover[i].lhs;
-      attrset rhs = minCover[i].rhs;
-
-      if (isSubset(rhs, lhs))
+      if (!bcnfFlags[i])
         continue;
 
-      attrset lhsClosure = computeClosure(lhs, minCover, minCount);
-
-      if (!isSubset(U, lhsClosure))
-      {
-        printAttrset(lhs);
-        printf(" -> ");
-        printAttrset(rhs);
-        printf("   (LHS is not a superkey)\n");
-      }
+      fprintAttrset(out, dict, minCover[i].lhs);
+      fprintf(out, " -> ");
+      fprintAttrset(out, dict, minCover[i].rhs);
+      fprintf(out, "   (LHS is not a superkey)\n");
     }
   }
 
   /* ---------------------------------------------------------
-     5) Impressão das violações de 3NF
+     4) Impressão das violações de 3NF
   --------------------------------------------------------- */
-  if (nf3Ok)
+  if (nf3Violations == 0)
   {
-    printf("3NF: OK\n");
+    fprintf(out, "3NF: OK\n");
   }
   else
   {
-    printf("3NF: Violations (%d)\n", nf3Violations);
+    fprintf(out, "3NF: Violations (%d)\n", nf3Violations);
 
     for (int i = 0; i < minCount; ++i)
     {
-      attrset lhs = minCover[i].lhs;
-      attrset rhs = minCover[i].rhs;
-
-      if (isSubset(rhs, lhs))
+      if (!nf3Flags[i])
         continue;
 
-      attrset lhsClosure = computeClosure(lhs, minCover, minCount);
-      int lhsIsSuperkey = isSubset(U, lhsClosure);
-      int rhsIsPrime = isSubset(rhs, primeAttributes);
-
-      if (!lhsIsSuperkey && !rhsIsPrime)
-      {
-        printAttrset(lhs);
-        printf(" -> ");
-        printAttrset(rhs);
-        printf("   (Not superkey AND RHS is not prime)\n");
-      }
+      fprintAttrset(out, dict, minCover[i].lhs);
+      fprintf(out, " -> ");
+      fprintAttrset(out, dict, minCover[i].rhs);
+      fprintf(out, "   (Not superkey AND RHS is not prime)\n");
     }
   }
 
-  free(minCover);
-  free(candidateKeys);
+  scratchFree(scratch, nf3Flags);
+  scratchFree(scratch, bcnfFlags);
 }
@@ -2,9 +2,20 @@
 #define NORMALFORM_H
 
 #include "parser.h"
+#include "analysis.h"
 
 // Checks BCNF and 3NF for a given schema U and a list of FDs.
 // Prints the result directly (BCNF OK / violations, 3NF OK / violations).
-void checkNormalForms(attrset U, FD *fds, int fdCount);
+void checkNormalForms(const AttrDict *dict, attrset U, FD *fds, int fdCount);
+
+// Same report, reusing the cover, LHS closures and keys held by ctx.
+void printNormalForms(const AttrDict *dict, AnalysisContext *ctx);
+void fprintNormalForms(FILE *out, const AttrDict *dict, AnalysisContext *ctx);
+
+// Only the violation counts; 0, or -1 out of memory.
+int countNormalFormViolations(AnalysisContext *ctx, int *bcnfViolations, int *nf3Violations);
+
+// Per cover FD (analysisCover order): 1 where it violates BCNF / 3NF.
+int markNormalFormViolations(AnalysisContext *ctx, char *violatesBcnfOut, char *violates3nfOut);
 
 #endif
\ No newline at end of file
@@ -1,200 +1,748 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "parser.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-// Converte um caractere (A–Z ou a–z) em índice 0–25
-static int charToIndex(char c)
+/* ---------------------------------------------------------------
+   Dicionário de atributos
+   Nomes de um caractere são normalizados para maiúscula (a ≡ A),
+   como no formato original; nomes maiores diferenciam caixa.
+---------------------------------------------------------------- */
+static int isNameChar(char c)
 {
-  if (c >= 'A' && c <= 'Z')
-    return c - 'A';
-  if (c >= 'a' && c <= 'z')
-    return c - 'a';
-  return -1;
+  return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '#' || c == '$';
 }
 
-// Converte uma string (ex: "ABC") em um attrset (bitmask)
-attrset attrsetFromString(const char *s)
+static char foldChar(const char *name, size_t length, size_t i)
 {
-  attrset result = 0;
+  if (length == 1)
+    return (char)toupper((unsigned char)name[i]);
+  return name[i];
+}
 
-  for (size_t i = 0; s[i]; ++i)
+static uint32_t hashName(const char *name, size_t length)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < length; ++i)
   {
-    int idx = charToIndex(s[i]);
-    if (idx >= 0 && idx < 26)
-      result |= (1u << idx);
+    h ^= (unsigned char)foldChar(name, length, i);
+    h *= 16777619u;
   }
-
-  return result;
+  return h;
 }
 
-// Imprime attrset na forma compacta (ex: 0101 -> AC)
-void printAttrsetCompact(attrset set)
+void initAttrDict(AttrDict *dict)
 {
-  for (int i = 0; i < 26; ++i)
-    if (set & (1u << i))
-      putchar('A' + i);
+  memset(dict, 0, sizeof(AttrDict));
 }
 
-// Lê um arquivo inteiro para memória
-static char *readFile(const char *path)
+void freeAttrDict(AttrDict *dict)
 {
-  FILE *f = fopen(path, "rb");
-  if (!f)
-    return NULL;
+  for (int i = 0; i < dict->count; ++i)
+    free(dict->names[i]);
+  free(dict->names);
+  free(dict->slots);
+  memset(dict, 0, sizeof(AttrDict));
+}
 
-  fseek(f, 0, SEEK_END);
-  long size = ftell(f);
-  fseek(f, 0, SEEK_SET);
+int findAttribute(const AttrDict *dict, const char *name, size_t length)
+{
+  if (dict->slotCount == 0 || length == 0)
+    return -1;
 
-  char *buffer = malloc(size + 1);
-  if (!buffer)
+  uint32_t mask = (uint32_t)dict->slotCount - 1;
+  for (uint32_t h = hashName(name, length) & mask;; h = (h + 1) & mask)
   {
-    fclose(f);
-    return NULL;
+    int slot = dict->slots[h];
+    if (slot == 0)
+      return -1;
+
+    const char *candidate = dict->names[slot - 1];
+    size_t i = 0;
+    while (i < length && candidate[i] == foldChar(name, length, i))
+      i++;
+    if (i == length && candidate[length] == '\0')
+      return slot - 1;
   }
+}
+
+static int growDictSlots(AttrDict *dict)
+{
+  int slotCount = dict->slotCount ? dict->slotCount * 2 : 64;
+  int *slots = calloc(slotCount, sizeof(int));
+  if (!slots)
+    return -1;
 
-  fread(buffer, 1, size, f);
-  buffer[size] = '\0';
+  uint32_t mask = (uint32_t)slotCount - 1;
+  for (int i = 0; i < dict->count; ++i)
+  {
+    const char *name = dict->names[i];
+    uint32_t h = hashName(name, strlen(name)) & mask;
+    while (slots[h])
+      h = (h + 1) & mask;
+    slots[h] = i + 1;
+  }
 
-  fclose(f);
-  return buffer;
+  free(dict->slots);
+  dict->slots = slots;
+  dict->slotCount = slotCount;
+  return 0;
 }
 
-// Remove todos os espaços em branco (útil para parsing)
-static char *removeWhitespace(const char *s)
+static int insertName(AttrDict *dict, const char *name, size_t length, int reserve)
 {
-  size_t length = strlen(s);
-  char *clean = malloc(length + 1);
-  size_t j = 0;
+  int existing = findAttribute(dict, name, length);
+  if (existing >= 0)
+    return existing;
 
+  if (length == 0 || (reserve && attrsetReserve(dict->count + 1) != 0))
+    return -1;
+
+  if (dict->count >= dict->capacity)
+  {
+    int capacity = dict->capacity ? dict->capacity * 2 : 32;
+    char **names = realloc(dict->names, sizeof(char *) * capacity);
+    if (!names)
+      return -1;
+    dict->names = names;
+    dict->capacity = capacity;
+  }
+
+  /* Mantém a tabela hash com no máximo 50% de ocupação */
+  if ((dict->count + 1) * 2 > dict->slotCount && growDictSlots(dict) != 0)
+    return -1;
+
+  char *copy = malloc(length + 1);
+  if (!copy)
+    return -1;
   for (size_t i = 0; i < length; ++i)
-    if (!isspace((unsigned char)s[i]))
-      clean[j++] = s[i];
+    copy[i] = foldChar(name, length, i);
+  copy[length] = '\0';
+
+  int index = dict->count++;
+  dict->names[index] = copy;
+  if ((int)length > dict->maxNameLength)
+    dict->maxNameLength = (int)length;
+
+  uint32_t mask = (uint32_t)dict->slotCount - 1;
+  uint32_t h = hashName(copy, length) & mask;
+  while (dict->slots[h])
+    h = (h + 1) & mask;
+  dict->slots[h] = index + 1;
 
-  clean[j] = '\0';
-  return clean;
+  return index;
+}
+
+int internAttribute(AttrDict *dict, const char *name, size_t length)
+{
+  return insertName(dict, name, length, 1);
+}
+
+int internName(AttrDict *dict, const char *name, size_t length)
+{
+  return insertName(dict, name, length, 0);
 }
 
 /* ---------------------------------------------------------------
-   Extrai o conteúdo de algo no formato PREFIX { conteúdo }
-   Ex: U={ABC} → retorna "ABC"
+   Escopo de nomes de uma leitura. Num .fds, o índice no dicionário
+   é o próprio índice local. Num catálogo, os nomes vão direto para
+   o dicionário compartilhado (sem limite) e o escopo mapeia cada
+   índice dele para o índice local da relação em leitura; só os
+   nomes da relação contam para resolver palavras.
 ---------------------------------------------------------------- */
-static char *extractBraced(const char *buffer, const char *prefix)
+typedef struct
 {
-  const char *p = strstr(buffer, prefix);
-  if (!p)
-    return NULL;
+  AttrDict *dict;
+  int *local;        // índice local de cada nome do dict (-1: fora); NULL: o do dict
+  int localCapacity;
+  int *attributes;   // índice no dict de cada atributo local (só com local)
+  int count;
+  int capacity;
+  int maxNameLength; // maior nome local (só com local)
+} AttrScope;
+
+static AttrScope dictScope(AttrDict *dict)
+{
+  AttrScope scope = {0};
+  scope.dict = dict;
+  return scope;
+}
 
-  p += strlen(prefix);
+static int scopeMaxNameLength(const AttrScope *scope)
+{
+  return scope->local ? scope->maxNameLength : scope->dict->maxNameLength;
+}
 
-  /* Avança até encontrar '{' */
-  while (*p && *p != '{')
-    p++;
+static int scopeFind(const AttrScope *scope, const char *name, size_t length)
+{
+  int index = findAttribute(scope->dict, name, length);
+  if (!scope->local || index < 0)
+    return index;
+  return index < scope->localCapacity ? scope->local[index] : -1;
+}
 
-  if (!*p)
-    return NULL;
+static int scopeIntern(AttrScope *scope, const char *name, size_t length)
+{
+  if (!scope->local)
+    return internAttribute(scope->dict, name, length);
 
-  p++; /* pula '{' */
+  int index = internName(scope->dict, name, length);
+  if (index < 0)
+    return -1;
 
-  const char *q = p;
-  int depth = 1;
+  if (index >= scope->localCapacity)
+  {
+    int capacity = scope->localCapacity ? scope->localCapacity * 2 : 64;
+    while (capacity <= index)
+      capacity *= 2;
+    int *local = realloc(scope->local, sizeof(int) * capacity);
+    if (!local)
+      return -1;
+    for (int i = scope->localCapacity; i < capacity; ++i)
+      local[i] = -1;
+    scope->local = local;
+    scope->localCapacity = capacity;
+  }
 
-  /* Encontra o '}' correspondente */
-  while (*q && depth > 0)
+  if (scope->local[index] >= 0)
+    return scope->local[index];
+
+  if (attrsetReserve(scope->count + 1) != 0)
+    return -1;
+
+  if (scope->count >= scope->capacity)
   {
-    if (*q == '{')
-      depth++;
-    else if (*q == '}')
-      depth--;
-    if (depth > 0)
-      q++;
+    int capacity = scope->capacity ? scope->capacity * 2 : 32;
+    int *attributes = realloc(scope->attributes, sizeof(int) * capacity);
+    if (!attributes)
+      return -1;
+    scope->attributes = attributes;
+    scope->capacity = capacity;
   }
 
-  if (depth != 0)
-    return NULL;
+  scope->attributes[scope->count] = index;
+  scope->local[index] = scope->count;
+  if ((int)length > scope->maxNameLength)
+    scope->maxNameLength = (int)length;
+  return scope->count++;
+}
+
+/* ---------------------------------------------------------------
+   Resolve uma palavra (sequência de caracteres de nome) para
+   atributos:
+     1) nome conhecido                  -> o próprio atributo
+     2) concatenação de nomes conhecidos -> cada um (ex: "AB")
+     3) só letras, dicionário só com nomes de 1 caractere
+                                        -> uma letra por atributo
+     4) caso contrário                  -> novo atributo
+   Em declarações (U={...}) cada palavra é sempre um nome. Com
+   lookupOnly, só 1) e 2): o dicionário não muda e uma palavra
+   desconhecida dá -1.
+---------------------------------------------------------------- */
+static int resolveWord(AttrScope *scope, const char *word, size_t length, int declare, int lookupOnly,
+                       attrset *set)
+{
+  int index = scopeFind(scope, word, length);
+
+  if (index < 0 && !lookupOnly && (declare || length == 1))
+  {
+    index = scopeIntern(scope, word, length);
+    if (index < 0)
+      return -1;
+  }
+
+  if (index >= 0)
+  {
+    attrsetInsert(set, index);
+    return 0;
+  }
+
+  /* Segmentação gulosa pelo nome conhecido mais longo */
+  attrset parts = attrsetEmpty();
+  size_t pos = 0;
+
+  while (pos < length)
+  {
+    size_t maxLength = length - pos;
+    if (maxLength > (size_t)scopeMaxNameLength(scope))
+      maxLength = (size_t)scopeMaxNameLength(scope);
+
+    int found = -1;
+    size_t partLength = maxLength;
+    for (; partLength >= 1; --partLength)
+    {
+      found = scopeFind(scope, word + pos, partLength);
+      if (found >= 0)
+        break;
+    }
+
+    if (found < 0)
+      break;
+
+    attrsetInsert(&parts, found);
+    pos += partLength;
+  }
+
+  if (pos == length)
+  {
+    *set = attrsetUnion(*set, parts);
+    return 0;
+  }
 
-  size_t len = q - p;
-  char *out = malloc(len + 1);
-  memcpy(out, p, len);
-  out[len] = '\0';
+  if (lookupOnly)
+    return -1;
+
+  int onlyLetters = 1;
+  for (size_t i = 0; i < length; ++i)
+    if (!isalpha((unsigned char)word[i]))
+      onlyLetters = 0;
+
+  if (onlyLetters && scopeMaxNameLength(scope) <= 1)
+  {
+    for (size_t i = 0; i < length; ++i)
+    {
+      int letter = scopeIntern(scope, word + i, 1);
+      if (letter < 0)
+        return -1;
+      attrsetInsert(set, letter);
+    }
+    return 0;
+  }
+
+  index = scopeIntern(scope, word, length);
+  if (index < 0)
+    return -1;
+
+  attrsetInsert(set, index);
+  return 0;
+}
+
+// Converte uma lista de nomes (ex: "ABC", "emp_id dept") em attrset
+static int parseAttributeList(AttrScope *scope, const char *s, size_t length, int declare, int lookupOnly,
+                              attrset *out)
+{
+  attrset result = attrsetEmpty();
+  size_t i = 0;
+
+  while (i < length)
+  {
+    if (!isNameChar(s[i]))
+    {
+      i++;
+      continue;
+    }
+
+    size_t start = i;
+    while (i < length && isNameChar(s[i]))
+      i++;
+
+    if (resolveWord(scope, s + start, i - start, declare, lookupOnly, &result) != 0)
+      return -1;
+  }
+
+  *out = result;
+  return 0;
+}
+
+// Converte uma string (ex: "ABC") em um attrset
+attrset attrsetFromString(AttrDict *dict, const char *s)
+{
+  attrset result = attrsetEmpty();
+  AttrScope scope = dictScope(dict);
+
+  if (parseAttributeList(&scope, s, strlen(s), 0, 0, &result) != 0)
+    fprintf(stderr, "Error: too many attributes (max %d)\n", ATTRSET_MAX_ATTRS);
+
+  return result;
+}
+
+int attrsetFromKnownNames(const AttrDict *dict, const char *s, attrset *out)
+{
+  /* Com lookupOnly o dicionário só é consultado */
+  AttrScope scope = dictScope((AttrDict *)dict);
+  return parseAttributeList(&scope, s, strlen(s), 0, 1, out);
+}
+
+/* Imprime attrset na forma compacta: nomes de 1 caractere são
+   concatenados (ex: AC); com nomes maiores, separados por espaço */
+void printAttrsetCompact(const AttrDict *dict, attrset set)
+{
+  fprintAttrset(stdout, dict, set);
+}
+
+void fprintAttrset(FILE *out, const AttrDict *dict, attrset set)
+{
+  int separate = dict->maxNameLength > 1;
+  int first = 1;
 
-  return out;
+  for (int a = attrsetNext(set, 0); a >= 0; a = attrsetNext(set, a + 1))
+  {
+    if (a >= dict->count)
+      continue;
+    if (separate && !first)
+      putc(' ', out);
+    fputs(dict->names[a], out);
+    first = 0;
+  }
 }
 
-// Divide F={A->B,CD->E,...} em tokens ["A->B", "CD->E", ...]
-static char **splitFds(const char *s, int *outCount)
+/* ---------------------------------------------------------------
+   Leitura do arquivo: mapeado em memória (mmap), sem cópias.
+   Se o mmap não for possível (ex: pipe), lê para um buffer.
+---------------------------------------------------------------- */
+typedef struct
+{
+  const char *data;
+  size_t size;
+  int mapped;
+  int allocated; // data veio do malloc da leitura incremental
+} FdsBuffer;
+
+static int openFdsBuffer(const char *path, FdsBuffer *buffer)
 {
-  int capacity = 8;
-  char **array = malloc(sizeof(char *) * capacity);
-  *outCount = 0;
+  memset(buffer, 0, sizeof(FdsBuffer));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+  {
+    buffer->size = (size_t)info.st_size;
+    if (buffer->size == 0)
+    {
+      close(fd);
+      buffer->data = "";
+      return 0;
+    }
+
+    void *data = mmap(NULL, buffer->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      posix_madvise(data, buffer->size, POSIX_MADV_SEQUENTIAL);
+      close(fd);
+      buffer->data = data;
+      buffer->mapped = 1;
+      return 0;
+    }
+  }
 
-  size_t length = strlen(s);
-  size_t start = 0;
+  /* Fallback: leitura incremental. Um erro de leitura não é fim de
+     arquivo: o texto truncado não chega ao parser. */
+  size_t capacity = 1 << 16, size = 0;
+  char *data = malloc(capacity);
 
-  for (size_t i = 0; i <= length; ++i)
+  while (data)
   {
-    if (s[i] == ',' || s[i] == ';' || s[i] == '\0')
+    ssize_t got = read(fd, data + size, capacity - size);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got < 0)
     {
-      size_t tokenLen = i - start;
+      free(data);
+      data = NULL;
+      break;
+    }
+    if (got == 0)
+      break;
 
-      /* Remove espaços nos extremos */
-      while (tokenLen > 0 && isspace((unsigned char)s[start + tokenLen - 1]))
-        tokenLen--;
-      while (tokenLen > 0 && isspace((unsigned char)s[start]))
+    size += (size_t)got;
+    if (size == capacity)
+    {
+      char *grown = realloc(data, capacity * 2);
+      if (!grown)
       {
-        start++;
-        tokenLen--;
+        free(data);
+        data = NULL;
+        break;
       }
+      data = grown;
+      capacity *= 2;
+    }
+  }
 
-      if (tokenLen > 0)
-      {
-        if (*outCount >= capacity)
-        {
-          capacity *= 2;
-          array = realloc(array, sizeof(char *) * capacity);
-        }
+  close(fd);
+  if (!data)
+    return -1;
 
-        char *token = malloc(tokenLen + 1);
-        memcpy(token, s + start, tokenLen);
-        token[tokenLen] = '\0';
+  buffer->data = data;
+  buffer->size = size;
+  buffer->allocated = 1;
+  return 0;
+}
 
-        array[(*outCount)++] = token;
-      }
+static void closeFdsBuffer(FdsBuffer *buffer)
+{
+  if (buffer->mapped)
+    munmap((void *)buffer->data, buffer->size);
+  else if (buffer->allocated)
+    free((void *)buffer->data);
+}
 
-      start = i + 1;
+/* ---------------------------------------------------------------
+   Parser de passada única sobre o buffer.
+   Nomes e DFs são lidos diretamente do buffer (ponteiro +
+   tamanho); as DFs vão para um vetor que cresce por duplicação.
+---------------------------------------------------------------- */
+typedef struct
+{
+  const char *path;
+  const char *data;
+  size_t size;
+  size_t pos;
+
+  AttrScope *scope;
+  FD *fds;
+  int fdCount;
+  int fdCapacity;
+  attrset universe;
+  int sawDependencies;
+} FdsParser;
+
+// Reporta erro com linha, coluna e deslocamento no arquivo
+static void parseError(const FdsParser *parser, size_t offset, const char *message)
+{
+  int line = 1, column = 1;
+  for (size_t i = 0; i < offset && i < parser->size; ++i)
+  {
+    if (parser->data[i] == '\n')
+    {
+      line++;
+      column = 1;
     }
+    else
+      column++;
   }
 
-  return array;
+  fprintf(stderr, "Error: %s:%d:%d (offset %zu): %s\n",
+          parser->path, line, column, offset, message);
+}
+
+static void skipSpaces(FdsParser *parser)
+{
+  while (parser->pos < parser->size && isspace((unsigned char)parser->data[parser->pos]))
+    parser->pos++;
+}
+
+static int atArrow(const FdsParser *parser, size_t pos)
+{
+  return pos + 1 < parser->size && parser->data[pos] == '-' && parser->data[pos + 1] == '>';
 }
 
-// Converte um token "XY->Z" para lhs e rhs
-static int parseFdToken(const char *token, attrset *lhs, attrset *rhs)
+/* Percorre uma lista de nomes até um dos delimitadores (ou "->"),
+   devolvendo o trecho [begin, end). Outros símbolos são erro. */
+static int scanNameList(FdsParser *parser, const char *delimiters, int stopAtArrow,
+                        size_t *begin, size_t *end)
 {
-  const char *arrow = strstr(token, "->");
-  if (!arrow)
+  *begin = parser->pos;
+
+  while (parser->pos < parser->size)
+  {
+    char c = parser->data[parser->pos];
+
+    if (strchr(delimiters, c) || (stopAtArrow && atArrow(parser, parser->pos)))
+      break;
+
+    if (!isNameChar(c) && !isspace((unsigned char)c))
+    {
+      parseError(parser, parser->pos, "unexpected character");
+      return -1;
+    }
+    parser->pos++;
+  }
+
+  *end = parser->pos;
+  return 0;
+}
+
+/* U={ABCD}: formato antigo, uma palavra só de letras em que cada
+   letra é um atributo. Com vírgulas ou espaços, cada palavra é um nome. */
+static int isLegacyUniverse(const char *s, size_t length)
+{
+  size_t begin = 0, end = length;
+  while (begin < end && isspace((unsigned char)s[begin]))
+    begin++;
+  while (end > begin && isspace((unsigned char)s[end - 1]))
+    end--;
+
+  if (begin == end)
+    return 0;
+
+  for (size_t i = begin; i < end; ++i)
+    if (!isalpha((unsigned char)s[i]))
+      return 0;
+
+  return 1;
+}
+
+static int pushFd(FdsParser *parser, attrset lhs, attrset rhs)
+{
+  if (parser->fdCount >= parser->fdCapacity)
+  {
+    int capacity = parser->fdCapacity ? parser->fdCapacity * 2 : 64;
+    FD *fds = realloc(parser->fds, sizeof(FD) * capacity);
+    if (!fds)
+      return -1;
+    parser->fds = fds;
+    parser->fdCapacity = capacity;
+  }
+
+  parser->fds[parser->fdCount].lhs = lhs;
+  parser->fds[parser->fdCount].rhs = rhs;
+  parser->fdCount++;
+  return 0;
+}
+
+// Corpo de U={...}: nomes separados por vírgula ou espaço
+static int parseUniverseBody(FdsParser *parser)
+{
+  size_t bodyBegin = parser->pos;
+  size_t begin, end;
+
+  for (;;)
+  {
+    if (scanNameList(parser, "},", 0, &begin, &end) != 0)
+      return -1;
+    if (parser->pos >= parser->size || parser->data[parser->pos] != ',')
+      break;
+    parser->pos++;
+  }
+
+  const char *body = parser->data + bodyBegin;
+  size_t bodyLength = parser->pos - bodyBegin;
+
+  attrset universe;
+  if (parseAttributeList(parser->scope, body, bodyLength,
+                         !isLegacyUniverse(body, bodyLength), 0, &universe) != 0)
+  {
+    parseError(parser, bodyBegin, "too many attributes");
     return -1;
+  }
+
+  parser->universe = attrsetUnion(parser->universe, universe);
+  return 0;
+}
+
+// Corpo de F={...}: DFs "X->Y" separadas por vírgula ou ponto e vírgula
+static int parseDependencyBody(FdsParser *parser)
+{
+  for (;;)
+  {
+    skipSpaces(parser);
+    if (parser->pos >= parser->size || parser->data[parser->pos] == '}')
+      return 0;
+
+    char c = parser->data[parser->pos];
+    if (c == ',' || c == ';')
+    {
+      parser->pos++;
+      continue;
+    }
+
+    size_t fdOffset = parser->pos;
+    size_t lhsBegin, lhsEnd, rhsBegin, rhsEnd;
+
+    if (scanNameList(parser, ",;}", 1, &lhsBegin, &lhsEnd) != 0)
+      return -1;
+
+    if (!atArrow(parser, parser->pos))
+    {
+      parseError(parser, fdOffset, "expected '->' in functional dependency");
+      return -1;
+    }
+    parser->pos += 2;
 
-  size_t lhsLen = arrow - token;
-  size_t rhsLen = strlen(token) - lhsLen - 2;
+    if (scanNameList(parser, ",;}", 1, &rhsBegin, &rhsEnd) != 0)
+      return -1;
 
-  char *lhsStr = malloc(lhsLen + 1);
-  char *rhsStr = malloc(rhsLen + 1);
+    if (atArrow(parser, parser->pos))
+    {
+      parseError(parser, parser->pos, "unexpected '->'");
+      return -1;
+    }
 
-  memcpy(lhsStr, token, lhsLen);
-  lhsStr[lhsLen] = '\0';
+    attrset lhs, rhs;
+    if (parseAttributeList(parser->scope, parser->data + lhsBegin, lhsEnd - lhsBegin, 0, 0, &lhs) != 0 ||
+        parseAttributeList(parser->scope, parser->data + rhsBegin, rhsEnd - rhsBegin, 0, 0, &rhs) != 0)
+    {
+      parseError(parser, fdOffset, "too many attributes");
+      return -1;
+    }
 
-  memcpy(rhsStr, arrow + 2, rhsLen);
-  rhsStr[rhsLen] = '\0';
+    if (pushFd(parser, lhs, rhs) != 0)
+    {
+      fprintf(stderr, "Error: out of memory\n");
+      return -1;
+    }
 
-  *lhs = attrsetFromString(lhsStr);
-  *rhs = attrsetFromString(rhsStr);
+    parser->universe = attrsetUnion(parser->universe, attrsetUnion(lhs, rhs));
+  }
+}
 
-  free(lhsStr);
-  free(rhsStr);
+/* Uma seção NOME = { ... }. Seções desconhecidas são ignoradas. */
+static int parseSection(FdsParser *parser)
+{
+  size_t nameBegin = parser->pos;
+  while (parser->pos < parser->size && isNameChar(parser->data[parser->pos]))
+    parser->pos++;
+  size_t nameLength = parser->pos - nameBegin;
 
+  if (nameLength == 0)
+  {
+    parseError(parser, parser->pos, "expected section name");
+    return -1;
+  }
+
+  skipSpaces(parser);
+  if (parser->pos >= parser->size || parser->data[parser->pos] != '=')
+  {
+    parseError(parser, parser->pos, "expected '='");
+    return -1;
+  }
+  parser->pos++;
+
+  skipSpaces(parser);
+  if (parser->pos >= parser->size || parser->data[parser->pos] != '{')
+  {
+    parseError(parser, parser->pos, "expected '{'");
+    return -1;
+  }
+  size_t bodyOffset = ++parser->pos;
+
+  const char *name = parser->data + nameBegin;
+  int status = 0;
+
+  if (nameLength == 1 && toupper((unsigned char)name[0]) == 'U')
+    status = parseUniverseBody(parser);
+  else if (nameLength == 1 && toupper((unsigned char)name[0]) == 'F')
+  {
+    parser->sawDependencies = 1;
+    status = parseDependencyBody(parser);
+  }
+  else
+  {
+    while (parser->pos < parser->size && parser->data[parser->pos] != '}')
+      parser->pos++;
+  }
+
+  if (status != 0)
+    return -1;
+
+  if (parser->pos >= parser->size)
+  {
+    parseError(parser, bodyOffset - 1, "unterminated '{'");
+    return -1;
+  }
+  parser->pos++; /* pula '}' */
   return 0;
 }
 
@@ -203,61 +751,258 @@ static int parseFdToken(const char *token, attrset *lhs, attrset *rhs)
       U (universo)
       F (conjunto de FDs)
 ---------------------------------------------------------------- */
-FD *parseFdsFile(const char *path, attrset *outU, int *outFdCount)
+FD *parseFdsFile(const char *path, AttrDict *dict, attrset *outU, int *outFdCount)
 {
-  char *buffer = readFile(path);
-  if (!buffer)
+  FdsBuffer buffer;
+  if (openFdsBuffer(path, &buffer) != 0)
   {
     fprintf(stderr, "Error: cannot read %s\n", path);
     return NULL;
   }
 
-  char *clean = removeWhitespace(buffer);
-  free(buffer);
+  FD *fds = parseFdsText(path, buffer.data, buffer.size, dict, outU, outFdCount);
+  closeFdsBuffer(&buffer);
+  return fds;
+}
+
+FD *parseFdsText(const char *name, const char *text, size_t length, AttrDict *dict, attrset *outU,
+                 int *outFdCount)
+{
+  FdsParser parser = {0};
+  parser.path = name;
+  parser.data = text;
+  parser.size = length;
+  AttrScope scope = dictScope(dict);
+  parser.scope = &scope;
+  parser.universe = attrsetEmpty();
+
+  int status = 0;
+  for (;;)
+  {
+    skipSpaces(&parser);
+    if (parser.pos >= parser.size)
+      break;
 
-  /* ------------------ Lê U={...} ------------------ */
-  char *universeString = extractBraced(clean, "U=");
-  attrset universe = universeString ? attrsetFromString(universeString) : 0;
-  free(universeString);
+    if (parseSection(&parser) != 0)
+    {
+      status = -1;
+      break;
+    }
+  }
 
-  /* ------------------ Lê F={...} ------------------ */
-  char *fdsString = extractBraced(clean, "F=");
-  if (!fdsString)
+  if (status == 0 && !parser.sawDependencies)
   {
     fprintf(stderr, "Error: file missing F={...}\n");
-    free(clean);
+    status = -1;
+  }
+
+  if (status != 0)
+  {
+    free(parser.fds);
     return NULL;
   }
 
-  /* ------------------ Divide dependências ------------------ */
-  int tokenCount = 0;
-  char **tokens = splitFds(fdsString, &tokenCount);
+  /* Garante um vetor válido mesmo com F={} */
+  if (!parser.fds)
+    parser.fds = malloc(sizeof(FD));
 
-  FD *fds = malloc(sizeof(FD) * tokenCount);
-  int fdCount = 0;
+  *outU = parser.universe;
+  *outFdCount = parser.fdCount;
 
-  for (int i = 0; i < tokenCount; ++i)
+  return parser.fds;
+}
+
+/* ---------------------------------------------------------------
+   Catálogo: vários esquemas num arquivo, um por bloco
+       relation NOME { U={...} F={...} }
+   Uma passada sobre o arquivo; cada bloco é lido como um .fds
+   isolado, com os nomes internados direto em names e um mapa para
+   os índices locais, e entregue a visit. Com only,
+   os blocos de outros nomes só são atravessados (contando chaves,
+   sem parse) e a leitura para no bloco pedido.
+---------------------------------------------------------------- */
+static int parseRelationBody(FdsParser *parser, size_t blockOffset)
+{
+  for (;;)
   {
-    attrset lhs, rhs;
+    skipSpaces(parser);
+    if (parser->pos >= parser->size)
+    {
+      parseError(parser, blockOffset, "unterminated '{'");
+      return -1;
+    }
 
-    if (parseFdToken(tokens[i], &lhs, &rhs) == 0)
+    if (parser->data[parser->pos] == '}')
     {
-      fds[fdCount].lhs = lhs;
-      fds[fdCount].rhs = rhs;
-      fdCount++;
+      parser->pos++;
+      break;
+    }
+
+    if (parseSection(parser) != 0)
+      return -1;
+  }
+
+  if (!parser->sawDependencies)
+  {
+    parseError(parser, blockOffset, "relation missing F={...}");
+    return -1;
+  }
+  return 0;
+}
 
-      universe |= (lhs | rhs);
+static int skipRelationBody(FdsParser *parser, size_t blockOffset)
+{
+  int depth = 1;
+  while (parser->pos < parser->size && depth > 0)
+  {
+    char c = parser->data[parser->pos++];
+    if (c == '{')
+      depth++;
+    else if (c == '}')
+      depth--;
+  }
+
+  if (depth > 0)
+  {
+    parseError(parser, blockOffset, "unterminated '{'");
+    return -1;
+  }
+  return 0;
+}
+
+// Palavra de nome na posição atual (pode ser vazia)
+static size_t scanWord(FdsParser *parser)
+{
+  size_t begin = parser->pos;
+  while (parser->pos < parser->size && isNameChar(parser->data[parser->pos]))
+    parser->pos++;
+  return parser->pos - begin;
+}
+
+int parseFdsCatalogText(const char *name, const char *text, size_t length, const char *only, AttrDict *names,
+                        FdsRelationVisitor visit, void *context)
+{
+  FdsParser parser = {0};
+  parser.path = name;
+  parser.data = text;
+  parser.size = length;
+
+  /* O mapa começa com os nomes que names já tem, todos fora da relação */
+  AttrScope scope = dictScope(names);
+  scope.localCapacity = names->count > 64 ? names->count : 64;
+  scope.local = malloc(sizeof(int) * scope.localCapacity);
+  if (!scope.local)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return -1;
+  }
+  for (int i = 0; i < scope.localCapacity; ++i)
+    scope.local[i] = -1;
+  parser.scope = &scope;
+
+  int status = 0;
+
+  while (status == 0)
+  {
+    skipSpaces(&parser);
+    if (parser.pos >= parser.size)
+    {
+      if (only)
+      {
+        fprintf(stderr, "Error: %s: no relation named %s\n", name, only);
+        status = -1;
+      }
+      break;
+    }
+
+    size_t keywordBegin = parser.pos;
+    if (scanWord(&parser) != 8 || strncmp(text + keywordBegin, "relation", 8) != 0)
+    {
+      parseError(&parser, keywordBegin, "expected 'relation'");
+      status = -1;
+      break;
     }
 
-    free(tokens[i]);
+    skipSpaces(&parser);
+    size_t relationBegin = parser.pos;
+    size_t relationLength = scanWord(&parser);
+    if (relationLength == 0)
+    {
+      parseError(&parser, parser.pos, "expected relation name");
+      status = -1;
+      break;
+    }
+
+    skipSpaces(&parser);
+    if (parser.pos >= parser.size || text[parser.pos] != '{')
+    {
+      parseError(&parser, parser.pos, "expected '{'");
+      status = -1;
+      break;
+    }
+    size_t blockOffset = parser.pos++;
+
+    const char *relation = text + relationBegin;
+    int wanted = !only || (strlen(only) == relationLength && strncmp(only, relation, relationLength) == 0);
+    if (!wanted)
+    {
+      status = skipRelationBody(&parser, blockOffset);
+      continue;
+    }
+
+    scope.attributes = NULL;
+    scope.count = 0;
+    scope.capacity = 0;
+    scope.maxNameLength = 0;
+    parser.fds = NULL;
+    parser.fdCount = 0;
+    parser.fdCapacity = 0;
+    parser.universe = attrsetEmpty();
+    parser.sawDependencies = 0;
+
+    status = parseRelationBody(&parser, blockOffset);
+
+    /* Limpa o mapa para o próximo bloco */
+    for (int a = 0; a < scope.count; ++a)
+      scope.local[scope.attributes[a]] = -1;
+
+    /* Garante vetores válidos mesmo com F={} e U={} */
+    if (status == 0 && !parser.fds)
+      parser.fds = malloc(sizeof(FD));
+    if (status == 0 && !scope.attributes)
+      scope.attributes = malloc(sizeof(int));
+
+    if (status == 0 && parser.fds && scope.attributes)
+      status = visit(context, relation, relationLength, scope.attributes, scope.count, parser.universe,
+                     parser.fds, parser.fdCount) == 0 ? 0 : -1;
+    else
+    {
+      if (status == 0)
+        fprintf(stderr, "Error: out of memory\n");
+      free(scope.attributes);
+      free(parser.fds);
+      status = -1;
+    }
+
+    if (only)
+      break;
   }
 
-  free(tokens);
-  free(fdsString);
-  free(clean);
+  free(scope.local);
+  return status;
+}
 
-  *outU = universe;
-  *outFdCount = fdCount;
+int parseFdsCatalogFile(const char *path, const char *only, AttrDict *names, FdsRelationVisitor visit,
+                        void *context)
+{
+  FdsBuffer buffer;
+  if (openFdsBuffer(path, &buffer) != 0)
+  {
+    fprintf(stderr, "Error: cannot read %s\n", path);
+    return -1;
+  }
 
-  return fds;
+  int status = parseFdsCatalogText(path, buffer.data, buffer.size, only, names, visit, context);
+  closeFdsBuffer(&buffer);
+  return status;
 }
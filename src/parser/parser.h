@@ -1,9 +1,10 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stddef.h>
 #include <stdint.h>
-
-typedef uint32_t attrset;
+#include <stdio.h>
+#include "attrset.h"
 
 typedef struct
 {
@@ -11,10 +12,63 @@ typedef struct
   attrset rhs;
 } FD;
 
-attrset attrsetFromString(const char *s);
+/* Dicionário de atributos: nome <-> índice no attrset */
+typedef struct
+{
+  char **names;
+  int count;
+  int capacity;
+
+  int *slots;     // tabela hash aberta: índice + 1 (0 = vazio)
+  int slotCount;
+
+  int maxNameLength;
+} AttrDict;
+
+void initAttrDict(AttrDict *dict);
+void freeAttrDict(AttrDict *dict);
+
+// Índice do atributo, ou -1 se não existe
+int findAttribute(const AttrDict *dict, const char *name, size_t length);
+
+// Índice do atributo, criando-o se necessário; -1 se excede a capacidade
+int internAttribute(AttrDict *dict, const char *name, size_t length);
+
+/* Como internAttribute, sem limite de atributos: para dicionários só de
+   nomes, cujos índices não entram em attrsets (ex: o de um catálogo) */
+int internName(AttrDict *dict, const char *name, size_t length);
+
+attrset attrsetFromString(AttrDict *dict, const char *s);
+
+/* Como attrsetFromString, mas só com nomes já conhecidos: não altera o
+   dicionário (seguro entre threads). -1 se alguma palavra não é um nome
+   nem uma concatenação de nomes. */
+int attrsetFromKnownNames(const AttrDict *dict, const char *s, attrset *out);
+
+void printAttrsetCompact(const AttrDict *dict, attrset set);
+void fprintAttrset(FILE *out, const AttrDict *dict, attrset set);
+
+FD *parseFdsFile(const char *path, AttrDict *dict, attrset *outU, int *outFdCount);
+
+// O mesmo sobre um texto em memória; name só aparece nas mensagens de erro
+FD *parseFdsText(const char *name, const char *text, size_t length, AttrDict *dict, attrset *outU,
+                 int *outFdCount);
 
-void printAttrsetCompact(attrset set);
+/* Catálogo: vários blocos "relation NOME { U={...} F={...} }" num arquivo,
+   lidos numa passada. Os nomes de atributo vão direto para names (sem
+   limite); cada bloco é lido como um .fds isolado e entregue a visit com o
+   índice em names de cada atributo local, na ordem do bloco, e as suas
+   FDs em índices locais. attributes e fds passam a ser de visit (mesmo se
+   ela falhar). Com only != NULL, só o bloco desse nome é lido: os
+   anteriores são pulados sem parse e os seguintes nem são percorridos;
+   com names vazio, os índices em names são então os locais. 0, ou -1 com
+   erro em stderr (ou se visit retornar != 0). */
+typedef int (*FdsRelationVisitor)(void *context, const char *name, size_t nameLength, int *attributes,
+                                  int attributeCount, attrset U, FD *fds, int fdCount);
 
-FD *parseFdsFile(const char *path, attrset *outU, int *outFdCount);
+int parseFdsCatalogFile(const char *path, const char *only, AttrDict *names, FdsRelationVisitor visit,
+                        void *context);
+int parseFdsCatalogText(const char *name, const char *text, size_t length, const char *only, AttrDict *names,
+                        FdsRelationVisitor visit, void *context);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,694 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+#include "analysis.h"
+#include "closurecache.h"
+#include "fdb.h"
+#include "keyindex.h"
+#include "normalform.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Pedidos de fecho seguidos sobre o mesmo esquema são fechados juntos */
+#define SERVER_CLOSURE_BATCH 256
+
+/* Conexões aceitas esperando uma thread livre */
+#define SERVER_QUEUE_SIZE 256
+
+/* Maior linha de pedido aceita */
+#define SERVER_MAX_LINE (1 << 20)
+
+/* ---------------------------------------------------------------
+   Esquemas residentes: carregados no primeiro pedido e mantidos
+   até o fim do processo (os ponteiros nunca mudam)
+---------------------------------------------------------------- */
+typedef struct
+{
+  char *path;
+  uint32_t hash;
+
+  AttrDict dict;
+  FdSchema schema;
+  AnalysisContext ctx;
+
+  const FD *cover;
+  int coverCount;
+  ClosureIndex *coverIndex;
+
+  /* Chaves e atributos primos, calculados uma vez sob keysLock;
+     keysReady só é publicado depois (lido sem a trava) */
+  pthread_mutex_t keysLock;
+  int keysReady;
+  int keysFailed;
+  KeyIndex keyIndex;
+} ResidentSchema;
+
+static ResidentSchema **residents = NULL;
+static int residentCount = 0;
+static int residentCapacity = 0;
+static pthread_mutex_t residentsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hashPath(const char *path)
+{
+  uint32_t h = 2166136261u;
+  for (; *path; ++path)
+    h = (h ^ (unsigned char)*path) * 16777619u;
+  return h;
+}
+
+static void freeResident(ResidentSchema *resident)
+{
+  freeAnalysisContext(&resident->ctx);
+  freeSchema(&resident->schema);
+  freeAttrDict(&resident->dict);
+  pthread_mutex_destroy(&resident->keysLock);
+  free(resident->path);
+  free(resident);
+}
+
+/* Carrega o esquema e calcula o que todo pedido usa: cobertura,
+   índice de fecho e fechos dos LHS (para as formas normais). Num
+   catálogo, path é "arquivo#relação": se path não é um arquivo, o que
+   vem depois do último '#' é a relação. */
+static ResidentSchema *loadResident(const char *path, uint32_t hash)
+{
+  ResidentSchema *resident = calloc(1, sizeof(ResidentSchema));
+  if (!resident)
+    return NULL;
+
+  pthread_mutex_init(&resident->keysLock, NULL);
+  initAttrDict(&resident->dict);
+  resident->hash = hash;
+  resident->path = strdup(path);
+
+  /* A carga alarga os conjuntos só até o que o esquema pede; o contexto
+     guarda essa largura para os pedidos */
+  char *file = strdup(path);
+  char *relation = file ? strrchr(file, '#') : NULL;
+  if (relation && access(file, F_OK) == 0)
+    relation = NULL;
+  if (relation)
+    *relation++ = '\0';
+
+  attrsetUseWords(1);
+  int loaded = resident->path && file && loadSchemaRelation(file, relation, &resident->dict, &resident->schema) == 0;
+  free(file);
+  if (!loaded)
+  {
+    freeResident(resident);
+    return NULL;
+  }
+
+  FdSchema *schema = &resident->schema;
+  initAnalysisContext(&resident->ctx, schema->U, schema->fds, schema->fdCount);
+  analysisUsePrecomputed(&resident->ctx, schema->cover, schema->coverCount, schema->closureIndex,
+                         schema->keys, schema->keyCount);
+
+  resident->cover = analysisCover(&resident->ctx, &resident->coverCount);
+  resident->coverIndex = analysisCoverIndex(&resident->ctx);
+  if (!resident->coverIndex || !analysisLhsClosures(&resident->ctx) || analysisFailed(&resident->ctx))
+  {
+    fprintf(stderr, "Error: out of memory loading %s\n", path);
+    freeResident(resident);
+    return NULL;
+  }
+
+  /* O cache do contexto só serve aos fechos dos LHS, já calculados */
+  analysisReleaseClosureCache(&resident->ctx);
+  return resident;
+}
+
+// Chamada com residentsLock
+static ResidentSchema *findResident(const char *path, uint32_t hash)
+{
+  for (int i = 0; i < residentCount; ++i)
+    if (residents[i]->hash == hash && strcmp(residents[i]->path, path) == 0)
+      return residents[i];
+  return NULL;
+}
+
+/* O esquema de path, carregado agora se ainda não está. A carga é feita
+   fora da trava, para um esquema grande não parar os pedidos dos outros;
+   se dois pedidos carregarem o mesmo arquivo juntos, fica o primeiro. */
+static ResidentSchema *getResident(const char *path)
+{
+  uint32_t hash = hashPath(path);
+
+  pthread_mutex_lock(&residentsLock);
+  ResidentSchema *resident = findResident(path, hash);
+  pthread_mutex_unlock(&residentsLock);
+  if (resident)
+    return resident;
+
+  ResidentSchema *loaded = loadResident(path, hash);
+  if (!loaded)
+    return NULL;
+
+  pthread_mutex_lock(&residentsLock);
+  resident = findResident(path, hash);
+  if (!resident && residentCount == residentCapacity)
+  {
+    int capacity = residentCapacity ? residentCapacity * 2 : 64;
+    ResidentSchema **grown = realloc(residents, sizeof(ResidentSchema *) * capacity);
+    if (grown)
+    {
+      residents = grown;
+      residentCapacity = capacity;
+    }
+  }
+  if (!resident && residentCount < residentCapacity)
+  {
+    residents[residentCount++] = loaded;
+    resident = loaded;
+    loaded = NULL;
+  }
+  pthread_mutex_unlock(&residentsLock);
+
+  if (loaded)
+    freeResident(loaded);
+  return resident;
+}
+
+/* Enumera as chaves na primeira vez; depois disso o contexto inteiro
+   é só leitura. 0 ou -1 se faltou memória. */
+static int ensureKeys(ResidentSchema *resident)
+{
+  if (!__atomic_load_n(&resident->keysReady, __ATOMIC_ACQUIRE))
+  {
+    pthread_mutex_lock(&resident->keysLock);
+    if (!resident->keysReady)
+    {
+      int keyCount = 0;
+      const attrset *keys = analysisKeys(&resident->ctx, &keyCount);
+      analysisPrimeAttributes(&resident->ctx);
+
+      int failed = analysisFailed(&resident->ctx) || initKeyIndex(&resident->keyIndex) != 0;
+      for (int i = 0; i < keyCount && !failed; ++i)
+        failed = keyIndexInsert(&resident->keyIndex, keys[i]) != 0;
+
+      resident->keysFailed = failed;
+      __atomic_store_n(&resident->keysReady, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&resident->keysLock);
+  }
+
+  return resident->keysFailed ? -1 : 0;
+}
+
+/* ---------------------------------------------------------------
+   Pedidos
+---------------------------------------------------------------- */
+typedef struct
+{
+  FILE *out;
+  ClosureCache *cache; // da thread, para todos os esquemas (NULL = sem cache)
+
+  /* Pedidos de fecho ainda sem resposta, todos sobre batchSchema
+     (batchAttrs aponta para as linhas, ainda no buffer de leitura) */
+  ResidentSchema *batchSchema;
+  attrset batch[SERVER_CLOSURE_BATCH];
+  const char *batchAttrs[SERVER_CLOSURE_BATCH];
+  char batchValid[SERVER_CLOSURE_BATCH];
+  int batchCount;
+} Connection;
+
+static void endResponse(Connection *connection)
+{
+  fputs(".\n", connection->out);
+}
+
+static void respondError(Connection *connection, const char *message, const char *detail)
+{
+  fprintf(connection->out, "Error: %s%s\n", message, detail);
+  endResponse(connection);
+}
+
+// Responde os fechos pendentes, na ordem dos pedidos
+static void flushClosureBatch(Connection *connection)
+{
+  ResidentSchema *resident = connection->batchSchema;
+  int count = connection->batchCount;
+  if (count == 0)
+    return;
+
+  attrsetUseWords(resident->ctx.attrWords);
+
+  if (connection->cache)
+    cachedClosureBatch(connection->cache, resident->coverIndex, connection->batch, connection->batch, count, 1);
+  else
+    computeClosureBatch(resident->coverIndex, connection->batch, connection->batch, count);
+
+  for (int q = 0; q < count; ++q)
+  {
+    if (connection->batchValid[q])
+    {
+      fprintAttrset(connection->out, &resident->dict, connection->batch[q]);
+      putc('\n', connection->out);
+      endResponse(connection);
+    }
+    else
+      respondError(connection, "unknown attributes in ", connection->batchAttrs[q]);
+  }
+
+  connection->batchCount = 0;
+  connection->batchSchema = NULL;
+}
+
+static void queueClosure(Connection *connection, ResidentSchema *resident, const char *attrs)
+{
+  if (connection->batchSchema != resident || connection->batchCount == SERVER_CLOSURE_BATCH)
+    flushClosureBatch(connection);
+  attrsetUseWords(resident->ctx.attrWords);
+
+  int q = connection->batchCount++;
+  connection->batchSchema = resident;
+  connection->batchAttrs[q] = attrs;
+  connection->batchValid[q] = (char)(attrsetFromKnownNames(&resident->dict, attrs, &connection->batch[q]) == 0);
+  if (!connection->batchValid[q])
+    connection->batch[q] = attrsetEmpty();
+}
+
+static void respondSuperkey(Connection *connection, ResidentSchema *resident, const char *attrs)
+{
+  attrset X, key;
+  if (attrsetFromKnownNames(&resident->dict, attrs, &X) != 0)
+  {
+    respondError(connection, "unknown attributes in ", attrs);
+    return;
+  }
+
+  if (!keyIndexFindSubset(&resident->keyIndex, X, &key))
+    fputs("not a superkey\n", connection->out);
+  else if (attrsetEquals(key, X))
+    fputs("key\n", connection->out);
+  else
+  {
+    fputs("superkey ", connection->out);
+    fprintAttrset(connection->out, &resident->dict, key);
+    putc('\n', connection->out);
+  }
+  endResponse(connection);
+}
+
+// Separa a próxima palavra de *line (NULL se não há)
+static char *nextWord(char **line)
+{
+  char *word = *line + strspn(*line, " \t");
+  if (*word == '\0')
+    return NULL;
+
+  char *end = word + strcspn(word, " \t");
+  *line = *end ? end + 1 : end;
+  *end = '\0';
+  return word;
+}
+
+/* Atende uma linha. Retorna 1 se a conexão deve ser encerrada. */
+static int handleRequest(Connection *connection, char *line)
+{
+  line[strcspn(line, "\r")] = '\0';
+
+  char *verb = nextWord(&line);
+  if (!verb)
+    return 0;
+
+  if (strcmp(verb, "quit") == 0)
+    return 1;
+
+  int needsAttrs = strcmp(verb, "closure") == 0 || strcmp(verb, "superkey") == 0;
+  int known = needsAttrs || strcmp(verb, "load") == 0 || strcmp(verb, "mincover") == 0 ||
+              strcmp(verb, "keys") == 0 || strcmp(verb, "normalform") == 0;
+
+  char *path = nextWord(&line);
+  if (!known || !path || (needsAttrs && line[strspn(line, " \t")] == '\0'))
+  {
+    flushClosureBatch(connection);
+    respondError(connection, known ? "missing arguments to " : "unknown request ", verb);
+    return 0;
+  }
+
+  ResidentSchema *resident = getResident(path);
+  if (resident && strcmp(verb, "closure") == 0)
+  {
+    queueClosure(connection, resident, line);
+    return 0;
+  }
+
+  flushClosureBatch(connection);
+  if (!resident)
+  {
+    respondError(connection, "cannot load ", path);
+    return 0;
+  }
+  attrsetUseWords(resident->ctx.attrWords);
+
+  FILE *out = connection->out;
+
+  if (strcmp(verb, "load") == 0)
+    fprintf(out, "%d attributes, %d fds, %d in the minimum cover\n", attrsetCount(resident->schema.U),
+            resident->schema.fdCount, resident->coverCount);
+  else if (strcmp(verb, "mincover") == 0)
+  {
+    for (int i = 0; i < resident->coverCount; ++i)
+    {
+      fprintAttrset(out, &resident->dict, resident->cover[i].lhs);
+      fputs("->", out);
+      fprintAttrset(out, &resident->dict, resident->cover[i].rhs);
+      putc('\n', out);
+    }
+  }
+  else if (ensureKeys(resident) != 0)
+  {
+    respondError(connection, "out of memory", "");
+    return 0;
+  }
+  else if (strcmp(verb, "superkey") == 0)
+  {
+    respondSuperkey(connection, resident, line);
+    return 0;
+  }
+  else if (strcmp(verb, "keys") == 0)
+  {
+    int keyCount = 0;
+    const attrset *keys = analysisKeys(&resident->ctx, &keyCount);
+    for (int i = 0; i < keyCount; ++i)
+    {
+      fprintAttrset(out, &resident->dict, keys[i]);
+      putc('\n', out);
+    }
+  }
+  else
+    fprintNormalForms(out, &resident->dict, &resident->ctx);
+
+  endResponse(connection);
+  return 0;
+}
+
+/* Lê pedidos até o cliente fechar a conexão (ou pedir quit). Cada
+   leitura pode trazer vários pedidos: todos são atendidos, com os fechos
+   em lote, e as respostas saem juntas. */
+static void serveConnection(Connection *connection, int fd)
+{
+  size_t capacity = 1 << 16;
+  size_t length = 0;
+  char *buffer = malloc(capacity);
+  int done = buffer == NULL;
+
+  while (!done)
+  {
+    if (length + 1 == capacity)
+    {
+      char *grown = capacity < SERVER_MAX_LINE ? realloc(buffer, capacity * 2) : NULL;
+      if (!grown)
+      {
+        respondError(connection, "request line too long", "");
+        break;
+      }
+      buffer = grown;
+      capacity *= 2;
+    }
+
+    ssize_t received = read(fd, buffer + length, capacity - length - 1);
+    if (received < 0 && errno == EINTR)
+      continue;
+
+    /* No fim da conexão, uma última linha sem '\n' também vale */
+    if (received <= 0)
+    {
+      if (length > 0)
+      {
+        buffer[length] = '\0';
+        handleRequest(connection, buffer);
+      }
+      break;
+    }
+    length += (size_t)received;
+
+    size_t begin = 0;
+    char *newline;
+    while (!done && (newline = memchr(buffer + begin, '\n', length - begin)) != NULL)
+    {
+      *newline = '\0';
+      done = handleRequest(connection, buffer + begin);
+      begin = (size_t)(newline - buffer) + 1;
+    }
+    flushClosureBatch(connection);
+    memmove(buffer, buffer + begin, length - begin);
+    length -= begin;
+
+    if (fflush(connection->out) != 0)
+      done = 1;
+  }
+
+  flushClosureBatch(connection);
+  fflush(connection->out);
+  free(buffer);
+}
+
+/* ---------------------------------------------------------------
+   Threads: o laço principal aceita conexões e as enfileira; cada
+   thread atende uma conexão por vez
+---------------------------------------------------------------- */
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t notEmpty;
+  pthread_cond_t notFull;
+  int fds[SERVER_QUEUE_SIZE];
+  int head;
+  int count;
+  int stopping;
+  int *active; // conexão atendida por cada thread (-1 = nenhuma)
+} ConnectionQueue;
+
+static ConnectionQueue queue;
+
+typedef struct
+{
+  int id;
+  pthread_t thread;
+} ServerWorker;
+
+static void *workerMain(void *arg)
+{
+  ServerWorker *worker = arg;
+
+  size_t cacheEntries = getClosureCacheEntries();
+  Connection connection;
+  memset(&connection, 0, sizeof(connection));
+  connection.cache = cacheEntries > 0 ? createClosureCache(cacheEntries) : NULL;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&queue.lock);
+    while (queue.count == 0 && !queue.stopping)
+      pthread_cond_wait(&queue.notEmpty, &queue.lock);
+    if (queue.stopping)
+    {
+      pthread_mutex_unlock(&queue.lock);
+      break;
+    }
+
+    int fd = queue.fds[queue.head];
+    queue.head = (queue.head + 1) % SERVER_QUEUE_SIZE;
+    queue.count--;
+    queue.active[worker->id] = fd;
+    pthread_cond_signal(&queue.notFull);
+    pthread_mutex_unlock(&queue.lock);
+
+    connection.out = fdopen(fd, "w");
+    if (connection.out)
+    {
+      setvbuf(connection.out, NULL, _IOFBF, 1 << 16);
+      serveConnection(&connection, fd);
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    queue.active[worker->id] = -1;
+    pthread_mutex_unlock(&queue.lock);
+
+    if (connection.out)
+      fclose(connection.out);
+    else
+      close(fd);
+  }
+
+  freeClosureCache(connection.cache);
+  return NULL;
+}
+
+/* ---------------------------------------------------------------
+   Socket e sinais
+---------------------------------------------------------------- */
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signal)
+{
+  (void)signal;
+  stopRequested = 1;
+}
+
+// 1 se já há um servidor atendendo em address
+static int serverListening(const struct sockaddr_un *address)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return 0;
+  int connected = connect(fd, (const struct sockaddr *)address, sizeof(*address)) == 0;
+  close(fd);
+  return connected;
+}
+
+static int openListeningSocket(const char *path)
+{
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path))
+  {
+    fprintf(stderr, "Error: socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    fprintf(stderr, "Error: cannot create socket: %s\n", strerror(errno));
+    return -1;
+  }
+
+  int bound = bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+
+  /* Um socket deixado por um servidor que não está mais no ar é trocado */
+  struct stat info;
+  if (!bound && errno == EADDRINUSE && stat(path, &info) == 0 && S_ISSOCK(info.st_mode) &&
+      !serverListening(&address))
+    bound = unlink(path) == 0 && bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+
+  if (!bound || listen(fd, SOMAXCONN) != 0)
+  {
+    fprintf(stderr, "Error: cannot listen on %s: %s\n", path, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int runServer(const char *socketPath, int workers)
+{
+  int listenFd = openListeningSocket(socketPath);
+  if (listenFd < 0)
+    return -1;
+
+  /* Sem SA_RESTART: o sinal interrompe o accept do laço principal.
+     As threads nascem com SIGINT/SIGTERM bloqueados, para que o sinal
+     chegue sempre a ele. */
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = requestStop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  sigset_t stopSignals, previous;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+
+  memset(&queue, 0, sizeof(queue));
+  pthread_mutex_init(&queue.lock, NULL);
+  pthread_cond_init(&queue.notEmpty, NULL);
+  pthread_cond_init(&queue.notFull, NULL);
+
+  ServerWorker *pool = malloc(sizeof(ServerWorker) * workers);
+  queue.active = malloc(sizeof(int) * workers);
+  int started = 0;
+  if (pool && queue.active)
+  {
+    for (; started < workers; ++started)
+    {
+      pool[started].id = started;
+      queue.active[started] = -1;
+      if (pthread_create(&pool[started].thread, NULL, workerMain, &pool[started]) != 0)
+        break;
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+  if (started == 0)
+  {
+    fprintf(stderr, "Error: cannot start server threads\n");
+    free(pool);
+    free(queue.active);
+    close(listenFd);
+    unlink(socketPath);
+    return -1;
+  }
+
+  fprintf(stderr, "serve: listening on %s with %d threads\n", socketPath, started);
+
+  while (!stopRequested)
+  {
+    int client = accept(listenFd, NULL, NULL);
+    if (client < 0)
+    {
+      if (errno != EINTR && errno != ECONNABORTED)
+      {
+        fprintf(stderr, "Error: accept failed: %s\n", strerror(errno));
+        break;
+      }
+      continue;
+    }
+
+    pthread_mutex_lock(&queue.lock);
+    while (queue.count == SERVER_QUEUE_SIZE)
+      pthread_cond_wait(&queue.notFull, &queue.lock);
+    queue.fds[(queue.head + queue.count) % SERVER_QUEUE_SIZE] = client;
+    queue.count++;
+    pthread_cond_signal(&queue.notEmpty);
+    pthread_mutex_unlock(&queue.lock);
+  }
+
+  /* Encerramento: conexões na fila são fechadas e as em atendimento
+     terminam na próxima leitura */
+  pthread_mutex_lock(&queue.lock);
+  queue.stopping = 1;
+  for (; queue.count > 0; queue.count--)
+  {
+    close(queue.fds[queue.head]);
+    queue.head = (queue.head + 1) % SERVER_QUEUE_SIZE;
+  }
+  for (int w = 0; w < started; ++w)
+    if (queue.active[w] >= 0)
+      shutdown(queue.active[w], SHUT_RDWR);
+  pthread_cond_broadcast(&queue.notEmpty);
+  pthread_mutex_unlock(&queue.lock);
+
+  for (int w = 0; w < started; ++w)
+    pthread_join(pool[w].thread, NULL);
+
+  close(listenFd);
+  unlink(socketPath);
+
+  for (int i = 0; i < residentCount; ++i)
+    freeResident(residents[i]);
+  free(residents);
+  residents = NULL;
+  residentCount = residentCapacity = 0;
+
+  free(pool);
+  free(queue.active);
+  return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/* -----------------------------------------------------------------------------
+   Modo servidor (fdtool serve): um processo que fica no ar, atende pedidos
+   por um socket Unix e mantém os esquemas carregados entre um pedido e
+   outro.
+
+   Protocolo em texto, um pedido por linha; cada resposta são linhas de
+   saída (as mesmas dos comandos de linha) seguidas de uma linha só com ".":
+       load <arquivo>                    carrega (ou confere) o esquema
+       closure <arquivo> <ATTRS>         X+
+       superkey <arquivo> <ATTRS>        key | superkey K | not a superkey
+       mincover <arquivo>
+       keys <arquivo>
+       normalform <arquivo>
+       quit                              encerra a conexão
+   Erros saem como "Error: ..." antes do ".". <arquivo> é um .fds ou .fdb,
+   relativo ao diretório do servidor; vários pedidos podem ser enviados
+   sem esperar as respostas, que saem na ordem. Em <ATTRS> só valem nomes
+   do esquema: ao contrário da linha de comando, um nome desconhecido é
+   erro, não um atributo novo.
+
+   Cada esquema é carregado no primeiro pedido que o cita, junto com a
+   cobertura mínima, o índice de fecho e os fechos dos LHS; as chaves (e o
+   índice de superchaves) no primeiro pedido que precisa delas. Depois
+   disso tudo é só leitura, e os pedidos não esperam uns pelos outros.
+
+   Conexões são atendidas por um conjunto fixo de threads; cada uma tem o
+   seu cache de fechos, usado para todos os esquemas. Os algoritmos rodam
+   com uma thread por pedido.
+ ----------------------------------------------------------------------------- */
+
+/* Atende em socketPath com workers threads até SIGINT/SIGTERM.
+   0 ao encerrar normalmente, -1 com erro em stderr. */
+int runServer(const char *socketPath, int workers);
+
+#endif
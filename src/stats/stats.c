@@ -0,0 +1,313 @@
+#define _GNU_SOURCE
+
+#include "stats.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#if FDTOOL_STATS && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define STATS_HAVE_PERF 1
+#else
+#define STATS_HAVE_PERF 0
+#endif
+
+static int statsEnabled = 0;
+static const char *statsJsonPath = NULL;
+static int statsHardware = 0;
+
+void setStatsEnabled(int enabled)
+{
+  statsEnabled = enabled;
+}
+
+int getStatsEnabled(void)
+{
+  return statsEnabled;
+}
+
+void setStatsJsonPath(const char *path)
+{
+  statsJsonPath = path;
+}
+
+void setStatsHardwareCounters(int enabled)
+{
+  statsHardware = enabled;
+}
+
+#if FDTOOL_STATS
+
+static const char *statsCommand = "";
+
+static const char *phaseNames[STAT_PHASE_COUNT] = {
+    "load", "decompose", "extraneous", "redundant", "keys", "normalform",
+};
+
+static const char *counterNames[STAT_COUNTER_COUNT] = {
+    "closures",          "batch_closures",     "fixpoint_iterations", "fds_fired",
+    "extraneous_tests",  "redundancy_tests",   "key_states",          "prime_oracle_calls",
+    "cache_hits",        "cache_misses",       "cache_evictions",
+};
+
+static uint64_t nowNanos(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/* ---------------------------------------------------------------
+   Contadores: um vetor por thread, somado aos totais quando a
+   thread termina (destrutor da chave) e no relatório
+---------------------------------------------------------------- */
+int statsActive = 0;
+_Thread_local StatsThreadCounters statsThreadCounters;
+
+static uint64_t totals[STAT_COUNTER_COUNT];
+static pthread_key_t flushKey;
+static pthread_once_t flushKeyOnce = PTHREAD_ONCE_INIT;
+
+static void flushThreadCounters(void *arg)
+{
+  StatsThreadCounters *local = arg;
+  for (int c = 0; c < STAT_COUNTER_COUNT; ++c)
+  {
+    __atomic_add_fetch(&totals[c], local->counters[c], __ATOMIC_RELAXED);
+    local->counters[c] = 0;
+  }
+}
+
+static void createFlushKey(void)
+{
+  pthread_key_create(&flushKey, flushThreadCounters);
+}
+
+void registerStatsThread(void)
+{
+  pthread_once(&flushKeyOnce, createFlushKey);
+  pthread_setspecific(flushKey, &statsThreadCounters);
+  statsThreadCounters.registered = 1;
+}
+
+/* ---------------------------------------------------------------
+   Contadores de hardware (perf_event_open), herdados pelas
+   threads criadas depois da abertura
+---------------------------------------------------------------- */
+static const char *hardwareNames[STATS_HARDWARE_EVENTS] = {"cycles", "instructions", "cache_misses"};
+static int hardwareFds[STATS_HARDWARE_EVENTS] = {-1, -1, -1};
+static int hardwareOpen = 0;
+
+#if STATS_HAVE_PERF
+static int openHardwareCounter(uint64_t config)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.inherit = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static void openHardwareCounters(void)
+{
+#if STATS_HAVE_PERF
+  static const uint64_t configs[STATS_HARDWARE_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+
+  for (int e = 0; e < STATS_HARDWARE_EVENTS; ++e)
+  {
+    hardwareFds[e] = openHardwareCounter(configs[e]);
+    if (hardwareFds[e] < 0)
+    {
+      for (int k = 0; k < e; ++k)
+        close(hardwareFds[k]);
+      hardwareFds[0] = hardwareFds[1] = hardwareFds[2] = -1;
+      return;
+    }
+  }
+  hardwareOpen = 1;
+#endif
+}
+
+static void readHardwareCounters(uint64_t *values)
+{
+  for (int e = 0; e < STATS_HARDWARE_EVENTS; ++e)
+  {
+    values[e] = 0;
+    if (hardwareOpen && read(hardwareFds[e], &values[e], sizeof(uint64_t)) != sizeof(uint64_t))
+      values[e] = 0;
+  }
+}
+
+/* ---------------------------------------------------------------
+   Fases
+---------------------------------------------------------------- */
+static uint64_t phaseCalls[STAT_PHASE_COUNT];
+static uint64_t phaseNanos[STAT_PHASE_COUNT];
+static uint64_t phaseHardware[STAT_PHASE_COUNT][STATS_HARDWARE_EVENTS];
+
+StatsTimer beginStatsPhase(void)
+{
+  StatsTimer timer;
+  memset(&timer, 0, sizeof(timer));
+  if (statsActive)
+  {
+    readHardwareCounters(timer.hardware);
+    timer.start = nowNanos();
+  }
+  return timer;
+}
+
+void endStatsPhase(StatPhase phase, const StatsTimer *timer)
+{
+  if (!statsActive)
+    return;
+
+  uint64_t elapsed = nowNanos() - timer->start;
+  uint64_t hardware[STATS_HARDWARE_EVENTS];
+  readHardwareCounters(hardware);
+
+  __atomic_add_fetch(&phaseCalls[phase], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&phaseNanos[phase], elapsed, __ATOMIC_RELAXED);
+  for (int e = 0; e < STATS_HARDWARE_EVENTS; ++e)
+    __atomic_add_fetch(&phaseHardware[phase][e], hardware[e] - timer->hardware[e], __ATOMIC_RELAXED);
+}
+
+/* ---------------------------------------------------------------
+   Relatório
+---------------------------------------------------------------- */
+static uint64_t startNanos;
+
+static long peakMemoryKb(void)
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return usage.ru_maxrss; // KB no Linux
+}
+
+static void printTextReport(FILE *out, double seconds, const uint64_t *hardware)
+{
+  fprintf(out, "stats: %-12s %8s %12s", "phase", "calls", "time (ms)");
+  if (hardwareOpen)
+    fprintf(out, " %14s %14s %12s", "cycles", "instructions", "cache misses");
+  fprintf(out, "\n");
+
+  for (int p = 0; p < STAT_PHASE_COUNT; ++p)
+  {
+    if (phaseCalls[p] == 0)
+      continue;
+    fprintf(out, "stats: %-12s %8llu %12.3f", phaseNames[p], (unsigned long long)phaseCalls[p],
+            (double)phaseNanos[p] / 1e6);
+    if (hardwareOpen)
+      fprintf(out, " %14llu %14llu %12llu", (unsigned long long)phaseHardware[p][0],
+              (unsigned long long)phaseHardware[p][1], (unsigned long long)phaseHardware[p][2]);
+    fprintf(out, "\n");
+  }
+
+  for (int c = 0; c < STAT_COUNTER_COUNT; ++c)
+    if (totals[c] > 0)
+      fprintf(out, "stats: %-20s %llu\n", counterNames[c], (unsigned long long)totals[c]);
+
+  fprintf(out, "stats: total %.3f ms, peak memory %ld KB\n", seconds * 1e3, peakMemoryKb());
+  if (hardwareOpen)
+    fprintf(out, "stats: %llu cycles, %llu instructions, %llu cache misses\n", (unsigned long long)hardware[0],
+            (unsigned long long)hardware[1], (unsigned long long)hardware[2]);
+  else if (statsHardware)
+    fprintf(out, "stats: hardware counters unavailable\n");
+}
+
+static void printJsonReport(FILE *out, double seconds, const uint64_t *hardware)
+{
+  fprintf(out, "{\n  \"command\": \"%s\",\n  \"seconds\": %.9f,\n  \"peak_memory_kb\": %ld,\n", statsCommand,
+          seconds, peakMemoryKb());
+
+  fprintf(out, "  \"phases\": {");
+  const char *separator = "";
+  for (int p = 0; p < STAT_PHASE_COUNT; ++p)
+  {
+    if (phaseCalls[p] == 0)
+      continue;
+    fprintf(out, "%s\n    \"%s\": {\"calls\": %llu, \"seconds\": %.9f", separator, phaseNames[p],
+            (unsigned long long)phaseCalls[p], (double)phaseNanos[p] / 1e9);
+    for (int e = 0; e < STATS_HARDWARE_EVENTS && hardwareOpen; ++e)
+      fprintf(out, ", \"%s\": %llu", hardwareNames[e], (unsigned long long)phaseHardware[p][e]);
+    fprintf(out, "}");
+    separator = ",";
+  }
+  fprintf(out, "\n  },\n  \"counters\": {");
+
+  for (int c = 0; c < STAT_COUNTER_COUNT; ++c)
+    fprintf(out, "%s\n    \"%s\": %llu", c ? "," : "", counterNames[c], (unsigned long long)totals[c]);
+  fprintf(out, "\n  },\n  \"hardware\": ");
+
+  if (hardwareOpen)
+  {
+    fprintf(out, "{");
+    for (int e = 0; e < STATS_HARDWARE_EVENTS; ++e)
+      fprintf(out, "%s\"%s\": %llu", e ? ", " : "", hardwareNames[e], (unsigned long long)hardware[e]);
+    fprintf(out, "}\n}\n");
+  }
+  else
+    fprintf(out, "null\n}\n");
+}
+
+static void reportStats(void)
+{
+  statsActive = 0;
+  flushThreadCounters(&statsThreadCounters);
+
+  double seconds = (double)(nowNanos() - startNanos) / 1e9;
+  uint64_t hardware[STATS_HARDWARE_EVENTS];
+  readHardwareCounters(hardware);
+
+  if (statsJsonPath)
+  {
+    FILE *out = fopen(statsJsonPath, "w");
+    if (!out)
+    {
+      fprintf(stderr, "Error: cannot write %s\n", statsJsonPath);
+      return;
+    }
+    printJsonReport(out, seconds, hardware);
+    fclose(out);
+  }
+  else
+    printTextReport(stderr, seconds, hardware);
+}
+
+void startStats(const char *command)
+{
+  if (!statsEnabled)
+    return;
+
+  statsCommand = command;
+  if (statsHardware)
+    openHardwareCounters();
+
+  startNanos = nowNanos();
+  statsActive = 1;
+  atexit(reportStats);
+}
+
+#else
+
+void startStats(const char *command)
+{
+  (void)command;
+
+  if (statsEnabled)
+    fprintf(stderr, "stats: phase counters not compiled in (build with STATS=1)\n");
+}
+
+#endif
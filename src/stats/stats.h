@@ -0,0 +1,111 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+/* -----------------------------------------------------------------------------
+   Instrumentação: tempo por fase e contadores dos algoritmos.
+
+   Com FDTOOL_STATS=0 (make STATS=0) as macros STATS_* somem na compilação:
+   nenhum contador, teste ou chamada fica nos laços. Com 1 (padrão), cada
+   contador custa um teste de flag enquanto as estatísticas estão
+   desligadas; ligadas, soma num vetor da própria thread (_Thread_local),
+   juntado aos totais quando a thread termina. As fases só são medidas nos
+   pontos de entrada dos módulos, fora dos laços.
+
+   Os tempos das fases são inclusivos: fases chamadas dentro de outras
+   (ex: chaves pedidas pela 3NF) contam nas duas.
+
+   Opcionalmente (Linux), ciclos, instruções e faltas de cache são lidos
+   dos contadores de hardware via perf_event_open, para o processo todo e
+   por fase. Se o kernel recusar, o relatório só avisa.
+ ----------------------------------------------------------------------------- */
+#ifndef FDTOOL_STATS
+#define FDTOOL_STATS 1
+#endif
+
+typedef enum
+{
+  STAT_PHASE_LOAD,       // parse do .fds ou mapeamento do .fdb
+  STAT_PHASE_DECOMPOSE,  // cobertura: decomposição dos RHS
+  STAT_PHASE_EXTRANEOUS, // cobertura: atributos estranhos
+  STAT_PHASE_REDUNDANT,  // cobertura: DFs redundantes
+  STAT_PHASE_KEYS,       // enumeração de chaves candidatas
+  STAT_PHASE_NORMALFORM, // tabela de veredictos BCNF/3NF
+  STAT_PHASE_COUNT
+} StatPhase;
+
+typedef enum
+{
+  STAT_CLOSURES,            // fechos calculados um a um
+  STAT_BATCH_CLOSURES,      // fechos calculados em lote (bit-sliced)
+  STAT_FIXPOINT_ITERATIONS, // passadas sobre F dos laços iterativos e do lote
+  STAT_FDS_FIRED,           // FDs disparadas pelo LINCLOSURE
+  STAT_EXTRANEOUS_TESTS,    // testes de atributo estranho
+  STAT_REDUNDANCY_TESTS,    // testes de DF redundante
+  STAT_KEY_STATES,          // estados visitados pela busca de chaves
+  STAT_PRIME_ORACLE_CALLS,  // perguntas ao oráculo de atributos primos
+  STAT_CACHE_HITS,          // fechos achados no cache de fechos
+  STAT_CACHE_MISSES,        // fechos procurados e não achados
+  STAT_CACHE_EVICTIONS,     // entradas do cache sobrescritas pelo relógio
+  STAT_COUNTER_COUNT
+} StatCounter;
+
+/* Configuração (vale com ou sem FDTOOL_STATS; sem, o relatório só avisa) */
+void setStatsEnabled(int enabled);
+int getStatsEnabled(void);
+// Relatório em JSON neste arquivo em vez de stderr (NULL = stderr)
+void setStatsJsonPath(const char *path);
+void setStatsHardwareCounters(int enabled);
+
+/* Liga a coleta (se configurada) e agenda o relatório para a saída do
+   processo. command identifica o relatório. */
+void startStats(const char *command);
+
+#if FDTOOL_STATS
+
+typedef struct
+{
+  uint64_t counters[STAT_COUNTER_COUNT];
+  int registered;
+} StatsThreadCounters;
+
+extern int statsActive;
+extern _Thread_local StatsThreadCounters statsThreadCounters;
+
+// Registra a thread para que seus contadores entrem nos totais ao sair
+void registerStatsThread(void);
+
+static inline void statsCount(StatCounter counter, uint64_t amount)
+{
+  if (!statsActive)
+    return;
+  if (!statsThreadCounters.registered)
+    registerStatsThread();
+  statsThreadCounters.counters[counter] += amount;
+}
+
+#define STATS_HARDWARE_EVENTS 3
+
+typedef struct
+{
+  uint64_t start;
+  uint64_t hardware[STATS_HARDWARE_EVENTS];
+} StatsTimer;
+
+StatsTimer beginStatsPhase(void);
+void endStatsPhase(StatPhase phase, const StatsTimer *timer);
+
+#define STATS_COUNT(counter, amount) statsCount((counter), (amount))
+#define STATS_PHASE_BEGIN(timer) StatsTimer timer = beginStatsPhase()
+#define STATS_PHASE_END(phase, timer) endStatsPhase((phase), &(timer))
+
+#else
+
+#define STATS_COUNT(counter, amount) ((void)sizeof(amount))
+#define STATS_PHASE_BEGIN(timer) ((void)0)
+#define STATS_PHASE_END(phase, timer) ((void)0)
+
+#endif
+
+#endif
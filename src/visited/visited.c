@@ -0,0 +1,176 @@
+#include "visited.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int initVisitedTable(VisitedSet *set, size_t capacity)
+{
+  set->dense = 0;
+  set->capacity = capacity;
+  set->table = scratchAlloc(set->arena, sizeof(attrset) * capacity);
+  set->used = scratchCalloc(set->arena, capacity, 1);
+  return (set->table && set->used) ? 0 : -1;
+}
+
+// Posição de s no bitmap denso
+static size_t denseIndex(const VisitedSet *set, attrset s)
+{
+  size_t bit = 0;
+  for (int k = 0; k < set->positionCount; ++k)
+    if (attrsetHas(s, set->positions[k]))
+      bit |= (size_t)1 << k;
+  return bit;
+}
+
+int initVisitedSet(VisitedSet *set, attrset domain)
+{
+  memset(set, 0, sizeof(VisitedSet));
+  set->domain = domain;
+  set->arena = getScratchArena();
+
+  int domainSize = attrsetCount(domain);
+
+  if (domainSize <= VISITED_DENSE_MAX_ATTRS)
+  {
+    set->dense = 1;
+    for (int a = attrsetNext(domain, 0); a >= 0; a = attrsetNext(domain, a + 1))
+      set->positions[set->positionCount++] = a;
+
+    size_t words = ((size_t)1 << domainSize) / 64 + 1;
+    set->bits = scratchCalloc(set->arena, words, sizeof(uint64_t));
+    return set->bits ? 0 : -1;
+  }
+
+  return initVisitedTable(set, 1024);
+}
+
+void freeVisitedSet(VisitedSet *set)
+{
+  scratchFree(set->arena, set->bits);
+  scratchFree(set->arena, set->table);
+  scratchFree(set->arena, set->used);
+  memset(set, 0, sizeof(VisitedSet));
+}
+
+static int growVisitedTable(VisitedSet *set)
+{
+  size_t capacity = set->capacity * 2;
+  attrset *table = scratchAlloc(set->arena, sizeof(attrset) * capacity);
+  char *used = scratchCalloc(set->arena, capacity, 1);
+  if (!table || !used)
+  {
+    scratchFree(set->arena, table);
+    scratchFree(set->arena, used);
+    return -1;
+  }
+
+  for (size_t i = 0; i < set->capacity; ++i)
+  {
+    if (!set->used[i])
+      continue;
+
+    size_t h = attrsetHash(set->table[i]) & (capacity - 1);
+    while (used[h])
+      h = (h + 1) & (capacity - 1);
+    table[h] = set->table[i];
+    used[h] = 1;
+  }
+
+  scratchFree(set->arena, set->table);
+  scratchFree(set->arena, set->used);
+  set->table = table;
+  set->used = used;
+  set->capacity = capacity;
+  return 0;
+}
+
+int visitedInsert(VisitedSet *set, attrset s)
+{
+  if (set->dense)
+  {
+    size_t bit = denseIndex(set, s);
+    uint64_t mask = (uint64_t)1 << (bit & 63);
+    if (set->bits[bit >> 6] & mask)
+      return 0;
+    set->bits[bit >> 6] |= mask;
+    return 1;
+  }
+
+  /* Mantém ocupação abaixo de 50% */
+  if ((set->count + 1) * 2 > set->capacity && growVisitedTable(set) != 0)
+    return -1;
+
+  s = attrsetIntersect(s, set->domain);
+  size_t h = attrsetHash(s) & (set->capacity - 1);
+
+  while (set->used[h])
+  {
+    if (attrsetEquals(set->table[h], s))
+      return 0;
+    h = (h + 1) & (set->capacity - 1);
+  }
+
+  set->table[h] = s;
+  set->used[h] = 1;
+  set->count++;
+  return 1;
+}
+
+/* -----------------------------------------------------------------------------
+   Versão compartilhada
+ ----------------------------------------------------------------------------- */
+int initSharedVisitedSet(SharedVisitedSet *set, attrset domain)
+{
+  memset(set, 0, sizeof(SharedVisitedSet));
+
+  if (initVisitedSet(&set->dense, domain) != 0)
+    return -1;
+  if (set->dense.dense)
+    return 0;
+
+  freeVisitedSet(&set->dense);
+
+  for (int i = 0; i < VISITED_SHARDS; ++i)
+  {
+    set->shards[i].domain = domain;
+    if (initVisitedTable(&set->shards[i], 256) != 0)
+      return -1;
+    pthread_mutex_init(&set->locks[i], NULL);
+  }
+  return 0;
+}
+
+void freeSharedVisitedSet(SharedVisitedSet *set)
+{
+  if (set->dense.dense)
+  {
+    freeVisitedSet(&set->dense);
+    return;
+  }
+
+  for (int i = 0; i < VISITED_SHARDS; ++i)
+  {
+    if (set->shards[i].table)
+      pthread_mutex_destroy(&set->locks[i]);
+    freeVisitedSet(&set->shards[i]);
+  }
+}
+
+int sharedVisitedInsert(SharedVisitedSet *set, attrset s)
+{
+  if (set->dense.dense)
+  {
+    size_t bit = denseIndex(&set->dense, s);
+    uint64_t mask = (uint64_t)1 << (bit & 63);
+    uint64_t old = __atomic_fetch_or(&set->dense.bits[bit >> 6], mask, __ATOMIC_RELAXED);
+    return (old & mask) ? 0 : 1;
+  }
+
+  /* Bits altos escolhem o shard; os baixos, a posição dentro dele */
+  int shard = (int)(attrsetHash(attrsetIntersect(s, set->shards[0].domain)) >> 58);
+
+  pthread_mutex_lock(&set->locks[shard]);
+  int inserted = visitedInsert(&set->shards[shard], s);
+  pthread_mutex_unlock(&set->locks[shard]);
+
+  return inserted;
+}
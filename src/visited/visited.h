@@ -0,0 +1,61 @@
+#ifndef VISITED_H
+#define VISITED_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "attrset.h"
+#include "arena.h"
+
+/* Acima desse número de atributos no domínio usa tabela hash */
+#define VISITED_DENSE_MAX_ATTRS 24
+
+/* Conjunto de attrsets já visitados, com inserção/consulta O(1).
+   Só os atributos do domínio distinguem os conjuntos: dois attrsets que
+   diferem apenas fora dele são considerados iguais.
+     - domínio pequeno: bitmap denso com 2^|domínio| bits
+     - domínio grande:  hash com endereçamento aberto (sondagem linear) */
+typedef struct
+{
+  int dense;
+
+  /* Bitmap: i-ésimo atributo do domínio -> i-ésimo bit do índice */
+  int positions[VISITED_DENSE_MAX_ATTRS];
+  int positionCount;
+  uint64_t *bits;
+
+  /* Hash */
+  attrset domain;
+  attrset *table;
+  char *used;
+  size_t capacity;
+  size_t count;
+
+  Arena *arena; // arena de rascunho de quem criou (NULL = malloc)
+} VisitedSet;
+
+/* Os vetores vêm da arena de rascunho da thread que cria o conjunto; o
+   compartilhado usa malloc, porque cresce nas outras threads */
+int initVisitedSet(VisitedSet *set, attrset domain);
+void freeVisitedSet(VisitedSet *set);
+
+// 1 se s era novo (e foi inserido), 0 se já estava, -1 sem memória
+int visitedInsert(VisitedSet *set, attrset s);
+
+/* Versão compartilhada entre threads: o bitmap denso é atualizado com
+   operações atômicas; a tabela hash é dividida em shards, cada um com
+   seu mutex, escolhidos pelos bits altos do hash. */
+#define VISITED_SHARDS 64
+
+typedef struct
+{
+  VisitedSet dense;
+  VisitedSet shards[VISITED_SHARDS];
+  pthread_mutex_t locks[VISITED_SHARDS];
+} SharedVisitedSet;
+
+int initSharedVisitedSet(SharedVisitedSet *set, attrset domain);
+void freeSharedVisitedSet(SharedVisitedSet *set);
+int sharedVisitedInsert(SharedVisitedSet *set, attrset s);
+
+#endif